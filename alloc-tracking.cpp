@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <unistd.h>
+
+// allocation counting for the benchmark binary. this file replaces the global operator new and
+// delete, so it must be included by exactly one translation unit of a program (main.cpp).
+//
+// counters are thread_local and folded into process totals when a thread exits, totals() is exact
+// once the worker threads have been joined. with LFV_TRACK_MALLOC defined the whole malloc family
+// glibc lets a program replace is interposed too (malloc, calloc, realloc, free and the aligned
+// variants, through the __libc_* entry points), which also catches C libraries and the allocator
+// in std::thread; operator new then counts through malloc. every pointer free() sees must have
+// been counted on the way out, or frees outrun allocations.
+//
+// NoAllocationScope marks a path that must not allocate: an allocation on that thread while one
+// is active prints a message and aborts, so the core dump points at the offending call
+
+struct AllocationCounts {
+    uint64_t allocations_ = 0;
+    uint64_t frees_ = 0;
+    uint64_t bytes_ = 0;
+
+    AllocationCounts operator-(const AllocationCounts& other) const {
+        return {allocations_ - other.allocations_, frees_ - other.frees_, bytes_ - other.bytes_};
+    }
+
+    AllocationCounts& operator+=(const AllocationCounts& other) {
+        allocations_ += other.allocations_;
+        frees_ += other.frees_;
+        bytes_ += other.bytes_;
+        return *this;
+    }
+};
+
+class AllocationTracker {
+    struct ThreadCounts {
+        AllocationCounts counts_;
+        int forbidden_ = 0;
+
+        ~ThreadCounts() {
+            exited_allocations_.fetch_add(counts_.allocations_, std::memory_order_relaxed);
+            exited_frees_.fetch_add(counts_.frees_, std::memory_order_relaxed);
+            exited_bytes_.fetch_add(counts_.bytes_, std::memory_order_relaxed);
+            counts_ = AllocationCounts();
+        }
+    };
+
+    static inline std::atomic<uint64_t> exited_allocations_{0};
+    static inline std::atomic<uint64_t> exited_frees_{0};
+    static inline std::atomic<uint64_t> exited_bytes_{0};
+
+    static ThreadCounts& local() {
+        thread_local ThreadCounts counts;
+        return counts;
+    }
+
+    static void forbidden_allocation(size_t bytes) {
+        // no iostreams here, they may allocate
+        char message[96] = "allocation of ";
+        size_t length = 14;
+        char digits[24];
+        size_t n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + bytes % 10);
+            bytes /= 10;
+        } while (bytes);
+        while (n) message[length++] = digits[--n];
+        const char suffix[] = " bytes inside a NoAllocationScope\n";
+        for (char c : suffix) {
+            if (c) message[length++] = c;
+        }
+        ssize_t written = ::write(STDERR_FILENO, message, length);
+        (void)written;
+        std::abort();
+    }
+
+    friend class NoAllocationScope;
+
+public:
+    static void on_allocate(size_t bytes) {
+        ThreadCounts& counts = local();
+        if (counts.forbidden_ > 0) forbidden_allocation(bytes);
+        counts.counts_.allocations_++;
+        counts.counts_.bytes_ += bytes;
+    }
+
+    static void on_free() { local().counts_.frees_++; }
+
+    // threads that have exited plus the calling thread
+    static AllocationCounts totals() {
+        AllocationCounts totals = local().counts_;
+        totals.allocations_ += exited_allocations_.load(std::memory_order_relaxed);
+        totals.frees_ += exited_frees_.load(std::memory_order_relaxed);
+        totals.bytes_ += exited_bytes_.load(std::memory_order_relaxed);
+        return totals;
+    }
+};
+
+class NoAllocationScope {
+    bool active_;
+
+public:
+    explicit NoAllocationScope(bool active = true) : active_(active) {
+        if (active_) AllocationTracker::local().forbidden_++;
+    }
+
+    ~NoAllocationScope() {
+        if (active_) AllocationTracker::local().forbidden_--;
+    }
+
+    NoAllocationScope(const NoAllocationScope&) = delete;
+    NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+};
+
+#ifdef LFV_TRACK_MALLOC
+#include <malloc.h>
+
+// noexcept like glibc's own declarations, so including <malloc.h> or <cstdlib> after this still compiles
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void* __libc_valloc(size_t);
+void* __libc_pvalloc(size_t);
+void __libc_free(void*);
+
+void* malloc(size_t bytes) noexcept {
+    AllocationTracker::on_allocate(bytes);
+    return __libc_malloc(bytes);
+}
+
+void* calloc(size_t count, size_t bytes) noexcept {
+    AllocationTracker::on_allocate(count * bytes);
+    return __libc_calloc(count, bytes);
+}
+
+void* realloc(void* p, size_t bytes) noexcept {
+    AllocationTracker::on_allocate(bytes);
+    if (p) AllocationTracker::on_free();
+    return __libc_realloc(p, bytes);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t bytes) noexcept {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+    AllocationTracker::on_allocate(bytes);
+    void* p = __libc_memalign(alignment, bytes);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t bytes) noexcept {
+    AllocationTracker::on_allocate(bytes);
+    return __libc_memalign(alignment, bytes);
+}
+
+void* memalign(size_t alignment, size_t bytes) noexcept {
+    AllocationTracker::on_allocate(bytes);
+    return __libc_memalign(alignment, bytes);
+}
+
+void* valloc(size_t bytes) noexcept {
+    AllocationTracker::on_allocate(bytes);
+    return __libc_valloc(bytes);
+}
+
+void* pvalloc(size_t bytes) noexcept {
+    AllocationTracker::on_allocate(bytes);
+    return __libc_pvalloc(bytes);
+}
+
+void free(void* p) noexcept {
+    if (p) AllocationTracker::on_free();
+    __libc_free(p);
+}
+}
+#endif
+
+inline void* tracked_allocate(size_t bytes) {
+#ifndef LFV_TRACK_MALLOC
+    AllocationTracker::on_allocate(bytes);
+#endif
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+
+inline void* tracked_allocate(size_t bytes, std::align_val_t alignment) {
+#ifndef LFV_TRACK_MALLOC
+    AllocationTracker::on_allocate(bytes);
+#endif
+    void* p = nullptr;
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    if (::posix_memalign(&p, align, bytes ? bytes : 1) != 0) throw std::bad_alloc();
+    return p;
+}
+
+inline void tracked_deallocate(void* p) {
+    if (!p) return;
+#ifndef LFV_TRACK_MALLOC
+    AllocationTracker::on_free();
+#endif
+    std::free(p);
+}
+
+// the nothrow and array forms of the standard library forward to these
+void* operator new(size_t bytes) { return tracked_allocate(bytes); }
+void* operator new(size_t bytes, std::align_val_t alignment) { return tracked_allocate(bytes, alignment); }
+void operator delete(void* p) noexcept { tracked_deallocate(p); }
+void operator delete(void* p, size_t) noexcept { tracked_deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { tracked_deallocate(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { tracked_deallocate(p); }
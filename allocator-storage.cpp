@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "lock-free-vector.cpp"
+
+// storage policy that takes bucket memory from a standard Allocator and descriptors from a
+// separate memory resource, so buckets can sit in an arena, a huge-page pool or a per-node
+// resource while the small, short-lived descriptors go somewhere cheap.
+//
+// every bucket starts on an Alignment boundary (64 for cache lines, 2 MiB for huge pages).
+// std::allocator and polymorphic_allocator hand out exactly bucket_size * sizeof(T) bytes at that
+// alignment, so small buckets do not cost a whole huge page each. any other allocator only knows
+// its value type, it is rebound to a block type of the alignment and buckets round up to whole blocks
+template <typename T, typename Allocator = std::allocator<T>, size_t Alignment = alignof(T)>
+class AllocatorStorage {
+    static_assert((Alignment & (Alignment - 1)) == 0 && Alignment >= alignof(T), "alignment must be a power of two");
+
+private:
+    struct alignas(Alignment) Block {
+        unsigned char bytes_[Alignment];
+    };
+
+    using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Block>;
+    using BlockTraits = std::allocator_traits<BlockAllocator>;
+
+    static constexpr bool IS_PMR = std::is_same_v<Allocator, std::pmr::polymorphic_allocator<T>>;
+    static constexpr bool IS_STD = std::is_same_v<Allocator, std::allocator<T>>;
+
+    BlockAllocator allocator_;
+    std::pmr::memory_resource* descriptors_;
+
+    static size_t blocks_for(size_t bytes) {
+        return (bytes + sizeof(Block) - 1) / sizeof(Block);
+    }
+
+    void* allocate_bytes(size_t bytes) {
+        if constexpr (IS_PMR) {
+            return allocator_.resource()->allocate(bytes, Alignment);
+        } else if constexpr (IS_STD) {
+            return ::operator new(bytes, std::align_val_t(Alignment));
+        } else {
+            return BlockTraits::allocate(allocator_, blocks_for(bytes));
+        }
+    }
+
+    void deallocate_bytes(void* p, size_t bytes) {
+        if constexpr (IS_PMR) {
+            allocator_.resource()->deallocate(p, bytes, Alignment);
+        } else if constexpr (IS_STD) {
+            ::operator delete(p, bytes, std::align_val_t(Alignment));
+        } else {
+            BlockTraits::deallocate(allocator_, static_cast<Block*>(p), blocks_for(bytes));
+        }
+    }
+
+public:
+    explicit AllocatorStorage(const Allocator& allocator = Allocator(),
+                              std::pmr::memory_resource* descriptors = std::pmr::new_delete_resource())
+        : allocator_(allocator)
+        , descriptors_(descriptors) {}
+
+    T* allocate_bucket(size_t, size_t bucket_size) {
+        T* bucket = static_cast<T*>(allocate_bytes(bucket_size * sizeof(T)));
+        std::uninitialized_value_construct_n(bucket, bucket_size);
+        return bucket;
+    }
+
+    void release_bucket(T* bucket, size_t, size_t bucket_size) {
+        std::destroy_n(bucket, bucket_size);
+        deallocate_bytes(bucket, bucket_size * sizeof(T));
+    }
+
+    void recover(size_t&, uint32_t&, T**) {}
+
+    void publish(size_t, uint32_t) {}
+
+    std::pmr::memory_resource* descriptor_resource() { return descriptors_; }
+};
+
+// buckets from any memory resource, e.g. PmrLockFreeVector<int, 64> v(PmrStorage<int, 64>(&arena, &pool))
+template <typename T, size_t Alignment = alignof(T)>
+using PmrStorage = AllocatorStorage<T, std::pmr::polymorphic_allocator<T>, Alignment>;
+
+template <typename T, size_t Alignment = alignof(T)>
+using PmrLockFreeVector = LockFreeVector<T, PmrStorage<T, Alignment>>;
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+// low-overhead benchmark harness: vectors are called through their concrete type (no virtual
+// dispatch, no unique_ptr), threads persist across runs pinned to one cpu each, all of them leave
+// a barrier together, and operations come from streams generated before timing starts
+
+template<typename V, typename T>
+concept BenchVector = requires(V& v, const T& value, size_t i) {
+    v.push_back(value);
+    { v.pop_back() } -> std::convertible_to<T>;
+    v.write(i, value);
+    { v.read(i) } -> std::convertible_to<T>;
+    { v.size() } -> std::convertible_to<size_t>;
+};
+
+// persistent workers, worker i pinned to cpu i % hardware_concurrency where the kernel allows it.
+// run() hands the job to the first active workers, which leave a start barrier together. the
+// workers take the timestamps themselves, the caller may not be scheduled again before they finish
+class PinnedThreadPool {
+    using Clock = std::chrono::steady_clock;
+
+    int size_;
+    std::barrier<> start_;
+    std::barrier<> end_;
+    int active_ = 0;
+    std::function<void(int)> job_;
+    bool stop_ = false;
+    std::vector<Clock::time_point> started_;
+    std::vector<Clock::time_point> finished_;
+    std::vector<std::thread> threads_;
+
+public:
+    explicit PinnedThreadPool(int size)
+        : size_(size), start_(size + 1), end_(size + 1), started_(size), finished_(size) {
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i < size_; ++i) {
+            threads_.emplace_back([this, i]() {
+                for (;;) {
+                    start_.arrive_and_wait();
+                    if (stop_) return;
+                    if (i < active_) {
+                        started_[i] = Clock::now();
+                        job_(i);
+                        finished_[i] = Clock::now();
+                    }
+                    end_.arrive_and_wait();
+                }
+            });
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % cpus, &set);
+            pthread_setaffinity_np(threads_.back().native_handle(), sizeof(set), &set);
+        }
+    }
+
+    ~PinnedThreadPool() {
+        stop_ = true;
+        start_.arrive_and_wait();
+        for (auto& thread : threads_) thread.join();
+    }
+
+    PinnedThreadPool(const PinnedThreadPool&) = delete;
+    PinnedThreadPool& operator=(const PinnedThreadPool&) = delete;
+
+    int size() const { return size_; }
+
+    // job(i) on workers 0 .. active - 1, timed from the first start to the last finish
+    std::chrono::nanoseconds run(int active, std::function<void(int)> job) {
+        if (active > size_) throw std::invalid_argument("more active workers than pool threads");
+        active_ = active;
+        job_ = std::move(job);
+        start_.arrive_and_wait();
+        end_.arrive_and_wait();
+        auto first = *std::min_element(started_.begin(), started_.begin() + active);
+        auto last = *std::max_element(finished_.begin(), finished_.begin() + active);
+        return last - first;
+    }
+};
+
+enum class HarnessOpKind : uint32_t { PUSH_BACK, POP_BACK, WRITE, READ };
+
+struct HarnessOp {
+    HarnessOpKind op_;
+    uint32_t arg_;    // index for read and write, value for push_back
+};
+
+// percent of push_back, pop_back and write operations, the rest of the 100 are reads
+struct HarnessMix {
+    int push_;
+    int pop_;
+    int write_;
+};
+
+// one stream per thread. indices stay below preload, and the vector is filled with preload plus
+// every pop in the streams, so read and write never run past the end whatever the interleaving
+struct HarnessStreams {
+    std::vector<std::vector<HarnessOp>> streams_;
+    size_t fill_ = 0;
+
+    HarnessStreams(int num_threads, size_t ops_per_thread, HarnessMix mix, size_t preload) {
+        if (preload == 0) throw std::invalid_argument("preload must be positive");
+        streams_.resize(num_threads);
+        size_t pops = 0;
+        for (int t = 0; t < num_threads; ++t) {
+            std::mt19937_64 gen(static_cast<uint64_t>(t) + 1);
+            std::uniform_int_distribution<int> op_dist(0, 99);
+            std::uniform_int_distribution<uint32_t> index_dist(0, static_cast<uint32_t>(preload - 1));
+            auto& stream = streams_[t];
+            stream.reserve(ops_per_thread);
+            for (size_t i = 0; i < ops_per_thread; ++i) {
+                int roll = op_dist(gen);
+                if (roll < mix.push_) {
+                    stream.push_back({HarnessOpKind::PUSH_BACK, static_cast<uint32_t>(i)});
+                } else if (roll < mix.push_ + mix.pop_) {
+                    stream.push_back({HarnessOpKind::POP_BACK, 0});
+                    pops++;
+                } else if (roll < mix.push_ + mix.pop_ + mix.write_) {
+                    stream.push_back({HarnessOpKind::WRITE, index_dist(gen)});
+                } else {
+                    stream.push_back({HarnessOpKind::READ, index_dist(gen)});
+                }
+            }
+        }
+        fill_ = preload + pops;
+    }
+
+    size_t ops() const {
+        size_t total = 0;
+        for (const auto& stream : streams_) total += stream.size();
+        return total;
+    }
+};
+
+// wall-clock ns per operation and thread for each run, a fresh vector per run, filled outside
+// the timed region
+template<typename VectorType, typename T = int>
+    requires BenchVector<VectorType, T>
+std::vector<double> run_harness(PinnedThreadPool& pool, const HarnessStreams& streams, int num_runs) {
+    int num_threads = static_cast<int>(streams.streams_.size());
+    std::vector<double> ns_per_op;
+    for (int run = 0; run < num_runs; ++run) {
+        VectorType vec;
+        for (size_t i = 0; i < streams.fill_; ++i) vec.push_back(static_cast<T>(i));
+
+        auto elapsed = pool.run(num_threads, [&](int t) {
+            T sink{};
+            for (const HarnessOp& op : streams.streams_[t]) {
+                switch (op.op_) {
+                    case HarnessOpKind::PUSH_BACK: vec.push_back(static_cast<T>(op.arg_)); break;
+                    case HarnessOpKind::POP_BACK: sink += vec.pop_back(); break;
+                    case HarnessOpKind::WRITE: vec.write(op.arg_, static_cast<T>(op.arg_)); break;
+                    case HarnessOpKind::READ: sink += vec.read(op.arg_); break;
+                }
+            }
+            asm volatile("" : : "r"(sink));
+        });
+        ns_per_op.push_back(static_cast<double>(elapsed.count()) * num_threads / static_cast<double>(streams.ops()));
+    }
+    return ns_per_op;
+}
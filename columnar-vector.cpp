@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// struct-of-arrays variant of LockFreeVector: every field gets its own bucketed array, all
+// columns share one descriptor and therefore one size. push_back reserves the index once and the
+// pending write stores every column, so a scan over one field only pulls that field into cache
+template <typename... Fields>
+class ColumnarLockFreeVector {
+    static_assert(sizeof...(Fields) > 0, "a columnar vector needs at least one field");
+    static_assert((std::is_trivially_copyable_v<Fields> && ...), "columns are updated with CAS");
+
+public:
+    static constexpr uint32_t MAX_BUCKETS = 32;
+    static constexpr uint32_t FIRST_BUCKET_SIZE = 8;
+
+    using Record = std::tuple<Fields...>;
+
+    template <size_t C>
+    using Field = std::tuple_element_t<C, Record>;
+
+private:
+    // a whole-record write, every column is moved from old_val_ to new_val_ at (bucket_, index_)
+    struct WriteDescriptor {
+        size_t bucket_;
+        size_t index_;
+        Record old_val_;
+        Record new_val_;
+        bool completed_;
+
+        WriteDescriptor(size_t bucket, size_t index, const Record& old_val, const Record& new_val)
+            : bucket_(bucket)
+            , index_(index)
+            , old_val_(old_val)
+            , new_val_(new_val)
+            , completed_(false) {}
+    };
+
+    struct Descriptor {
+        size_t size_;
+        uint32_t counter_;
+        WriteDescriptor* pending_write_;
+
+        Descriptor(size_t s = 0, uint32_t c = 0, WriteDescriptor* w = nullptr)
+            : size_(s)
+            , counter_(c)
+            , pending_write_(w) {}
+    };
+
+    template <typename T>
+    using Column = std::array<std::atomic<T*>, MAX_BUCKETS>;
+
+    std::tuple<Column<Fields>...> columns_;
+
+    std::atomic<Descriptor*> descriptor_;
+
+    static size_t bucket_capacity(size_t bucket) { return FIRST_BUCKET_SIZE * (1UL << bucket); }
+
+    static void locate(size_t i, size_t& bucket, size_t& index) {
+        size_t pos = i + FIRST_BUCKET_SIZE;
+        size_t hi_bit = __builtin_clz(pos) ^ 31;
+        bucket = hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
+        index = pos ^ (1UL << hi_bit);
+    }
+
+    // columns allocate independently, the loser of a racing allocation frees its copy
+    template <size_t C>
+    Field<C>* column_bucket(size_t bucket) {
+        std::atomic<Field<C>*>& slot = std::get<C>(columns_)[bucket];
+        Field<C>* data = slot.load();
+        if (data) return data;
+
+        Field<C>* new_bucket = new Field<C>[bucket_capacity(bucket)]();
+        if (slot.compare_exchange_strong(data, new_bucket)) {
+            return new_bucket;
+        }
+        delete[] new_bucket;
+        return data;
+    }
+
+    template <size_t... C>
+    void allocate_buckets(size_t bucket, std::index_sequence<C...>) {
+        (column_bucket<C>(bucket), ...);
+    }
+
+    template <size_t C>
+    void complete_column(WriteDescriptor* write_op) {
+        Field<C>* data = std::get<C>(columns_)[write_op->bucket_].load();
+        std::atomic<Field<C>>* atomic_loc = reinterpret_cast<std::atomic<Field<C>>*>(&data[write_op->index_]);
+        Field<C> expected = std::get<C>(write_op->old_val_);
+        // a failed cas means a helper already stored this column
+        atomic_loc->compare_exchange_strong(expected, std::get<C>(write_op->new_val_));
+    }
+
+    template <size_t... C>
+    void complete_write(WriteDescriptor* write_op, std::index_sequence<C...>) {
+        if (write_op && !write_op->completed_) {
+            (complete_column<C>(write_op), ...);
+            write_op->completed_ = true;
+        }
+    }
+
+    void complete_write(WriteDescriptor* write_op) {
+        complete_write(write_op, std::index_sequence_for<Fields...>{});
+    }
+
+    template <size_t... C>
+    Record read_record(size_t bucket, size_t index, std::index_sequence<C...>) {
+        return Record(column_bucket<C>(bucket)[index]...);
+    }
+
+    template <size_t... C>
+    void release_columns(std::index_sequence<C...>) {
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            (delete[] std::get<C>(columns_)[i].load(), ...);
+        }
+    }
+
+public:
+    ColumnarLockFreeVector() : columns_(), descriptor_(new Descriptor(0, 0, nullptr)) {}
+
+    ColumnarLockFreeVector(const ColumnarLockFreeVector&) = delete;
+    ColumnarLockFreeVector& operator=(const ColumnarLockFreeVector&) = delete;
+
+    ~ColumnarLockFreeVector() {
+        release_columns(std::index_sequence_for<Fields...>{});
+        delete descriptor_.load();
+    }
+
+    // returns the position the record was stored at
+    size_t push_back(const Fields&... fields) {
+        Record record(fields...);
+        while (true) {
+            Descriptor* current_desc = descriptor_.load();
+            if (current_desc->pending_write_) {
+                complete_write(current_desc->pending_write_);
+            }
+
+            size_t bucket, index;
+            locate(current_desc->size_, bucket, index);
+            allocate_buckets(bucket, std::index_sequence_for<Fields...>{});
+
+            WriteDescriptor* write_op = new WriteDescriptor(bucket, index, Record(), record);
+            Descriptor* new_desc = new Descriptor(current_desc->size_ + 1, current_desc->counter_ + 1, write_op);
+
+            if (descriptor_.compare_exchange_strong(current_desc, new_desc)) {
+                complete_write(write_op);
+                return current_desc->size_;
+            }
+
+            delete write_op;
+            delete new_desc;
+        }
+    }
+
+    Record pop_back() {
+        while (true) {
+            Descriptor* current_desc = descriptor_.load();
+            if (current_desc->pending_write_) {
+                complete_write(current_desc->pending_write_);
+            }
+
+            if (current_desc->size_ == 0) {
+                throw std::out_of_range("empty");
+            }
+
+            size_t bucket, index;
+            locate(current_desc->size_ - 1, bucket, index);
+            Record value = read_record(bucket, index, std::index_sequence_for<Fields...>{});
+
+            WriteDescriptor* write_op = new WriteDescriptor(bucket, index, value, Record());
+            Descriptor* new_desc = new Descriptor(current_desc->size_ - 1, current_desc->counter_ + 1, write_op);
+
+            if (descriptor_.compare_exchange_strong(current_desc, new_desc)) {
+                complete_write(write_op);
+                return value;
+            }
+
+            delete write_op;
+            delete new_desc;
+        }
+    }
+
+    Record read(size_t i) {
+        size_t bucket, index;
+        locate(i, bucket, index);
+        return read_record(bucket, index, std::index_sequence_for<Fields...>{});
+    }
+
+    template <size_t C>
+    Field<C> read(size_t i) {
+        size_t bucket, index;
+        locate(i, bucket, index);
+        return column_bucket<C>(bucket)[index];
+    }
+
+    template <size_t C>
+    void write(size_t i, const Field<C>& value) {
+        size_t bucket, index;
+        locate(i, bucket, index);
+        reinterpret_cast<std::atomic<Field<C>>*>(&column_bucket<C>(bucket)[index])->store(value);
+    }
+
+    // hands column C over [begin, end) to f(const Field<C>* data, size_t count) one contiguous run
+    // per bucket, so the callback sees plain arrays it can vectorise
+    template <size_t C, typename F>
+    void scan(size_t begin, size_t end, F&& f) {
+        while (begin < end) {
+            size_t bucket, index;
+            locate(begin, bucket, index);
+            size_t count = std::min(bucket_capacity(bucket) - index, end - begin);
+            f(static_cast<const Field<C>*>(column_bucket<C>(bucket) + index), count);
+            begin += count;
+        }
+    }
+
+    size_t size() const {
+        return descriptor_.load()->size_;
+    }
+};
@@ -0,0 +1,296 @@
+// compares two result files written by the benchmark with LFV_RESULTS=<path>, configuration by
+// configuration, and exits with 1 when any of them got significantly slower.
+// usage: lfv_compare <baseline.json> <candidate.json> [--alpha=0.05] [--threshold=0.05] [--resamples=10000]
+//
+// speedup is baseline median / candidate median over the raw per-run times, above 1 is faster.
+// its 95% interval comes from a bootstrap over both sets of runs, the p value from a two-sided
+// Mann-Whitney U test (normal approximation with tie correction, coarse below ~8 runs a side).
+// a configuration regresses when p < alpha, the whole interval is below 1 and the speedup is
+// below 1 - threshold, so noise and negligible slowdowns do not fail the gate
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// just enough JSON for the result files: objects, arrays, strings, numbers and literals
+struct JsonValue {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } type_ = NUL;
+    double number_ = 0;
+    std::string string_;
+    std::vector<JsonValue> items_;
+    std::vector<std::pair<std::string, JsonValue>> members_;
+
+    const JsonValue* find(const std::string& key) const {
+        for (const auto& [name, value] : members_) {
+            if (name == key) return &value;
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+    const std::string& text_;
+    size_t pos_ = 0;
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string(what) + " at offset " + std::to_string(pos_));
+    }
+
+    void skip_space() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) pos_++;
+    }
+
+    bool consume(char c) {
+        skip_space();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    std::string parse_string() {
+        if (!consume('"')) fail("expected string");
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c == '\\' && pos_ < text_.size()) {
+                char e = text_[pos_++];
+                out += e == 'n' ? '\n' : e == 't' ? '\t' : e;
+            } else {
+                out += c;
+            }
+        }
+        if (!consume('"')) fail("unterminated string");
+        return out;
+    }
+
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    JsonValue parse() {
+        JsonValue value;
+        skip_space();
+        if (pos_ == text_.size()) fail("unexpected end");
+        char c = text_[pos_];
+        if (c == '{') {
+            pos_++;
+            value.type_ = JsonValue::OBJECT;
+            if (consume('}')) return value;
+            do {
+                std::string key = parse_string();
+                if (!consume(':')) fail("expected ':'");
+                value.members_.emplace_back(key, parse());
+            } while (consume(','));
+            if (!consume('}')) fail("expected '}'");
+        } else if (c == '[') {
+            pos_++;
+            value.type_ = JsonValue::ARRAY;
+            if (consume(']')) return value;
+            do {
+                value.items_.push_back(parse());
+            } while (consume(','));
+            if (!consume(']')) fail("expected ']'");
+        } else if (c == '"') {
+            value.type_ = JsonValue::STRING;
+            value.string_ = parse_string();
+        } else if (text_.compare(pos_, 4, "true") == 0 || text_.compare(pos_, 5, "false") == 0) {
+            value.type_ = JsonValue::BOOLEAN;
+            value.number_ = c == 't';
+            pos_ += c == 't' ? 4 : 5;
+        } else if (text_.compare(pos_, 4, "null") == 0) {
+            pos_ += 4;
+        } else {
+            char* end = nullptr;
+            value.type_ = JsonValue::NUMBER;
+            value.number_ = std::strtod(text_.c_str() + pos_, &end);
+            if (end == text_.c_str() + pos_) fail("unexpected character");
+            pos_ = static_cast<size_t>(end - text_.c_str());
+        }
+        return value;
+    }
+};
+
+// name -> raw per-run times, in file order
+std::vector<std::pair<std::string, std::vector<double>>> load_results(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open " + path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+    JsonValue root = JsonParser(text).parse();
+
+    const JsonValue* results = root.find("results");
+    if (!results || results->type_ != JsonValue::ARRAY) throw std::runtime_error(path + ": no results array");
+    std::vector<std::pair<std::string, std::vector<double>>> out;
+    for (const JsonValue& result : results->items_) {
+        const JsonValue* name = result.find("name");
+        const JsonValue* times = result.find("raw_times");
+        if (!name || !times || times->type_ != JsonValue::ARRAY) throw std::runtime_error(path + ": malformed result");
+        std::vector<double> raw;
+        for (const JsonValue& t : times->items_) raw.push_back(t.number_);
+        out.emplace_back(name->string_, std::move(raw));
+    }
+    return out;
+}
+
+double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+// two-sided p value of the Mann-Whitney U test
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b) {
+    std::vector<std::pair<double, int>> all;
+    for (double x : a) all.emplace_back(x, 0);
+    for (double x : b) all.emplace_back(x, 1);
+    std::sort(all.begin(), all.end());
+
+    double n1 = static_cast<double>(a.size()), n2 = static_cast<double>(b.size()), n = n1 + n2;
+    double rank_sum_a = 0, tie_term = 0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) j++;
+        double rank = (static_cast<double>(i + j) + 1) / 2.0;   // average of ranks i+1 .. j
+        for (size_t k = i; k < j; k++) {
+            if (all[k].second == 0) rank_sum_a += rank;
+        }
+        double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    double u = rank_sum_a - n1 * (n1 + 1) / 2;
+    double mean = n1 * n2 / 2;
+    double variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+    if (variance <= 0) return 1.0;
+    double z = (std::abs(u - mean) - 0.5) / std::sqrt(variance);
+    return std::erfc(std::max(z, 0.0) / std::sqrt(2.0));
+}
+
+// percentile bootstrap of median(baseline) / median(candidate)
+std::pair<double, double> bootstrap_speedup(const std::vector<double>& base, const std::vector<double>& cand,
+                                            int resamples) {
+    std::mt19937_64 gen(42);
+    std::vector<double> ratios, a(base.size()), b(cand.size());
+    ratios.reserve(resamples);
+    std::uniform_int_distribution<size_t> pick_a(0, base.size() - 1), pick_b(0, cand.size() - 1);
+    for (int r = 0; r < resamples; ++r) {
+        for (double& x : a) x = base[pick_a(gen)];
+        for (double& x : b) x = cand[pick_b(gen)];
+        double m = median(b);
+        if (m > 0) ratios.push_back(median(a) / m);
+    }
+    std::sort(ratios.begin(), ratios.end());
+    if (ratios.empty()) return {0, 0};
+    return {ratios[static_cast<size_t>(0.025 * (ratios.size() - 1))],
+            ratios[static_cast<size_t>(0.975 * (ratios.size() - 1))]};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> files;
+    double alpha = 0.05, threshold = 0.05;
+    int resamples = 10000;
+    bool bad_option = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            size_t used = 0;
+            if (arg.rfind("--alpha=", 0) == 0) {
+                alpha = std::stod(arg.substr(8), &used);
+                bad_option |= used != arg.size() - 8;
+            } else if (arg.rfind("--threshold=", 0) == 0) {
+                threshold = std::stod(arg.substr(12), &used);
+                bad_option |= used != arg.size() - 12;
+            } else if (arg.rfind("--resamples=", 0) == 0) {
+                resamples = std::stoi(arg.substr(12), &used);
+                bad_option |= used != arg.size() - 12 || resamples < 1;
+            } else {
+                files.push_back(arg);
+            }
+        } catch (const std::logic_error&) {   // invalid_argument and out_of_range
+            bad_option = true;
+        }
+        if (bad_option) {
+            std::cerr << "bad option " << arg << "\n";
+            break;
+        }
+    }
+    if (bad_option || files.size() != 2) {
+        std::cerr << "usage: " << argv[0]
+                  << " <baseline.json> <candidate.json> [--alpha=0.05] [--threshold=0.05] [--resamples=10000]\n";
+        return 2;
+    }
+
+    std::vector<std::pair<std::string, std::vector<double>>> baseline, candidate;
+    try {
+        baseline = load_results(files[0]);
+        candidate = load_results(files[1]);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+    std::map<std::string, const std::vector<double>*> by_name;
+    for (const auto& [name, times] : candidate) by_name[name] = &times;
+
+    int regressions = 0, improvements = 0, compared = 0;
+    std::cout << std::left << std::setw(56) << "configuration" << std::right << std::setw(12) << "base us"
+              << std::setw(12) << "cand us" << std::setw(9) << "speedup" << std::setw(18) << "95% ci"
+              << std::setw(9) << "p" << "\n";
+    for (const auto& [name, base] : baseline) {
+        auto it = by_name.find(name);
+        if (it == by_name.end()) {
+            std::cout << std::left << std::setw(56) << name << "  only in baseline\n";
+            continue;
+        }
+        const std::vector<double>& cand = *it->second;
+        by_name.erase(it);
+        if (base.size() < 2 || cand.size() < 2) {
+            std::cout << std::left << std::setw(56) << name << "  too few runs to compare\n";
+            continue;
+        }
+
+        compared++;
+        double base_median = median(base), cand_median = median(cand);
+        double speedup = cand_median > 0 ? base_median / cand_median : 0;
+        auto [low, high] = bootstrap_speedup(base, cand, resamples);
+        double p = mann_whitney_p(base, cand);
+        bool significant = p < alpha && (high < 1 || low > 1);
+        const char* verdict = "";
+        if (significant && high < 1 && speedup < 1 - threshold) {
+            verdict = "  REGRESSION";
+            regressions++;
+        } else if (significant && low > 1 && speedup > 1 + threshold) {
+            verdict = "  faster";
+            improvements++;
+        }
+
+        std::ostringstream ci;
+        ci << std::fixed << std::setprecision(3) << "[" << low << ", " << high << "]";
+        std::cout << std::left << std::setw(56) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << base_median << std::setw(12) << cand_median << std::setprecision(3)
+                  << std::setw(9) << speedup << std::setw(18) << ci.str() << std::setprecision(4)
+                  << std::setw(9) << p << verdict << "\n";
+    }
+    for (const auto& [name, times] : by_name) {
+        std::cout << std::left << std::setw(56) << name << "  only in candidate\n";
+    }
+
+    std::cout << std::defaultfloat << "\n" << compared << " compared, " << improvements << " faster, " << regressions << " regressed"
+              << " (alpha " << alpha << ", threshold " << threshold * 100 << "%)\n";
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lock-free-vector.cpp"
+
+// append-only log with a LockFreeVector as its in-memory index. every append also goes to a
+// write-ahead file; concurrent appenders are batched so one pwrite + fdatasync covers a whole
+// group. readers never touch the file and keep the vector's lock-free read path
+template <typename T>
+class DurableLog {
+    static_assert(std::is_trivially_copyable_v<T>, "DurableLog stores raw bytes of T");
+
+private:
+    static constexpr uint64_t MAGIC = 0x31304c4157564c46ULL; // "FLVWAL01"
+    static constexpr uint32_t VERSION = 1;
+
+    struct FileHeader {
+        uint64_t magic_;
+        uint32_t version_;
+        uint32_t elem_size_;
+    };
+
+    LockFreeVector<T> vec_;
+    int fd_;
+    size_t max_batch_;
+
+    // guards the staging buffer and the flush hand-off, never held across I/O
+    std::mutex mutex_;
+    std::condition_variable durable_cv_;
+    std::vector<T> staging_;       // appended but not yet handed to a flush
+    size_t staged_base_;           // log index of staging_[0]
+    bool flushing_;
+    std::exception_ptr failure_;   // set once a flush fails, the log takes no more appends
+
+    // records [0, durable_) are on disk
+    std::atomic<size_t> durable_;
+    // group commits that reached disk
+    std::atomic<size_t> flushes_{0};
+
+    [[noreturn]] static void throw_errno(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    static off_t offset_of(size_t index) {
+        return static_cast<off_t>(sizeof(FileHeader) + index * sizeof(T));
+    }
+
+    void write_all(const void* data, size_t bytes, off_t offset) {
+        const char* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t n = ::pwrite(fd_, p, bytes, offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("pwrite");
+            }
+            p += n;
+            bytes -= static_cast<size_t>(n);
+            offset += n;
+        }
+    }
+
+    void read_all(void* data, size_t bytes, off_t offset) {
+        char* p = static_cast<char*>(data);
+        while (bytes > 0) {
+            ssize_t n = ::pread(fd_, p, bytes, offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("pread");
+            }
+            if (n == 0) throw std::runtime_error("log truncated during recovery");
+            p += n;
+            bytes -= static_cast<size_t>(n);
+            offset += n;
+        }
+    }
+
+    // rebuilds vec_ from the file, a torn record at the tail is dropped
+    size_t recover() {
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) throw_errno("fstat");
+
+        if (st.st_size == 0) {
+            FileHeader header{MAGIC, VERSION, static_cast<uint32_t>(sizeof(T))};
+            write_all(&header, sizeof(header), 0);
+            if (::fdatasync(fd_) != 0) throw_errno("fdatasync");
+            return 0;
+        }
+
+        FileHeader header;
+        if (static_cast<size_t>(st.st_size) < sizeof(header)) throw std::runtime_error("log header truncated");
+        read_all(&header, sizeof(header), 0);
+        if (header.magic_ != MAGIC || header.version_ != VERSION || header.elem_size_ != sizeof(T)) {
+            throw std::runtime_error("log header mismatch");
+        }
+
+        size_t count = (static_cast<size_t>(st.st_size) - sizeof(header)) / sizeof(T);
+        std::vector<T> chunk(std::min<size_t>(count, 1 << 16));
+        for (size_t done = 0; done < count; ) {
+            size_t n = std::min(chunk.size(), count - done);
+            read_all(chunk.data(), n * sizeof(T), offset_of(done));
+            for (size_t i = 0; i < n; i++) {
+                vec_.push_back(chunk[i]);
+            }
+            done += n;
+        }
+
+        if (static_cast<off_t>(st.st_size) != offset_of(count) && ::ftruncate(fd_, offset_of(count)) != 0) {
+            throw_errno("ftruncate");
+        }
+        return count;
+    }
+
+    // caller holds lock and has checked flushing_ is false; the lock is dropped for the I/O.
+    // a failed batch leaves a hole in the file and fsync errors are not sticky, so instead of
+    // retrying the log is failed: durable_ stays where it was and every waiter gets the error
+    void flush_batch(std::unique_lock<std::mutex>& lock) {
+        flushing_ = true;
+        size_t n = std::min(staging_.size(), max_batch_);
+        std::vector<T> batch;
+        if (n == staging_.size()) {
+            batch.swap(staging_);
+        } else {
+            batch.assign(staging_.begin(), staging_.begin() + n);
+            staging_.erase(staging_.begin(), staging_.begin() + n);
+        }
+        size_t base = staged_base_;
+        staged_base_ += n;
+
+        lock.unlock();
+        try {
+            write_all(batch.data(), n * sizeof(T), offset_of(base));
+            if (::fdatasync(fd_) != 0) throw_errno("fdatasync");
+        } catch (...) {
+            lock.lock();
+            failure_ = std::current_exception();
+            flushing_ = false;
+            durable_cv_.notify_all();
+            throw;
+        }
+        lock.lock();
+
+        durable_.store(base + n, std::memory_order_release);
+        flushes_.fetch_add(1, std::memory_order_relaxed);
+        flushing_ = false;
+        durable_cv_.notify_all();
+    }
+
+public:
+    // opens or creates the log at path and replays it into memory.
+    // max_batch caps how many records a single group commit may carry
+    explicit DurableLog(const std::string& path, size_t max_batch = 4096)
+        : fd_(::open(path.c_str(), O_RDWR | O_CREAT, 0644))
+        , max_batch_(std::max<size_t>(max_batch, 1))
+        , staged_base_(0)
+        , flushing_(false)
+        , durable_(0) {
+        if (fd_ < 0) throw_errno("open");
+        try {
+            size_t recovered = recover();
+            staged_base_ = recovered;
+            durable_.store(recovered);
+        } catch (...) {
+            ::close(fd_);
+            throw;
+        }
+    }
+
+    DurableLog(const DurableLog&) = delete;
+    DurableLog& operator=(const DurableLog&) = delete;
+
+    ~DurableLog() {
+        try {
+            sync();
+        } catch (...) {}
+        ::close(fd_);
+    }
+
+    // makes the element visible in memory and queues it for the next group commit.
+    // throws the error of the failed flush once the log has failed
+    size_t append(const T& elem) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failure_) std::rethrow_exception(failure_);
+        size_t index = vec_.push_back(elem);
+        staging_.push_back(elem);
+        return index;
+    }
+
+    // blocks until every record up to and including index is on disk. one waiter becomes
+    // the leader and flushes everything staged so far, the rest ride along. throws when a flush
+    // failed before the record got to disk
+    void wait_durable(size_t index) {
+        if (durable_.load(std::memory_order_acquire) > index) return;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (durable_.load(std::memory_order_acquire) <= index) {
+            if (failure_) {
+                std::rethrow_exception(failure_);
+            } else if (!flushing_) {
+                flush_batch(lock);
+            } else {
+                durable_cv_.wait(lock);
+            }
+        }
+    }
+
+    // append and wait for durability
+    size_t push_back(const T& elem) {
+        size_t index = append(elem);
+        wait_durable(index);
+        return index;
+    }
+
+    void sync() {
+        size_t n = size();
+        if (n > 0) wait_durable(n - 1);
+    }
+
+    T read(size_t i) { return vec_.read(i); }
+
+    size_t size() const { return vec_.size(); }
+
+    size_t durable_size() const { return durable_.load(std::memory_order_acquire); }
+
+    // batches written since the log was opened, records made durable over this is the mean batch size
+    size_t flushes() const { return flushes_.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "latency-histogram.cpp"
+
+// flight recorder for vector operations: every thread appends fixed-size events to its own ring,
+// the newest RING_SIZE events per thread survive. dump() and the optional signal handler write all
+// rings to a binary file that trace2json turns into Chrome trace / Perfetto JSON.
+//
+// dump file layout:
+//   TraceFileHeader | (TraceRingHeader | TraceEvent[RING_SIZE]) * ring_count_
+// events in a ring are in slot order, slot head_ % RING_SIZE is the oldest once head_ >= RING_SIZE
+
+enum class TraceOp : uint8_t { PUSH_BACK, POP_BACK, WRITE, BUCKET_ALLOCATION, BUCKET_ALLOCATION_RACE };
+
+struct TraceEvent {
+    uint64_t start_;       // CycleClock ticks
+    uint64_t index_;       // element index, or bucket number for bucket events
+    uint32_t duration_;    // ticks, saturated
+    uint16_t retries_;
+    uint8_t op_;
+    uint8_t reserved_;
+};
+
+static constexpr uint64_t TRACE_MAGIC = 0x3130435254564c46ULL; // "FLVTRC01"
+static constexpr uint32_t TRACE_VERSION = 1;
+
+struct TraceFileHeader {
+    uint64_t magic_;
+    uint32_t version_;
+    uint32_t ring_count_;
+    uint32_t ring_size_;
+    uint32_t pid_;
+    double ns_per_tick_;
+};
+
+struct TraceRingHeader {
+    uint64_t head_;        // events ever written to the ring
+    uint32_t thread_id_;
+    uint32_t reserved_;
+};
+
+class FlightRecorder {
+public:
+    static constexpr size_t RING_SIZE = 4096;
+    static constexpr size_t MAX_RINGS = 256;
+
+private:
+    struct Ring {
+        std::atomic<uint64_t> head_{0};
+        std::atomic<bool> owned_{false};
+        uint32_t thread_id_ = 0;
+        TraceEvent events_[RING_SIZE];
+    };
+
+    // rings are never freed, a ring given up by an exiting thread is reused by the next one
+    static inline Ring* rings_[MAX_RINGS] = {};
+    static inline std::atomic<size_t> ring_count_{0};
+    static inline char signal_path_[4096] = {};
+
+    // releases the ring when its thread exits
+    struct RingOwner {
+        Ring* ring_ = nullptr;
+        ~RingOwner() {
+            if (ring_) ring_->owned_.store(false, std::memory_order_release);
+        }
+    };
+
+    static Ring* claim_ring() {
+        size_t count = ring_count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            bool owned = false;
+            if (rings_[i]->owned_.compare_exchange_strong(owned, true)) {
+                return rings_[i];
+            }
+        }
+        Ring* ring = new Ring();
+        ring->owned_.store(true);
+        size_t slot = ring_count_.load();
+        // publish the ring before the count so a signal handler never sees a null slot
+        while (slot < MAX_RINGS) {
+            Ring* expected = nullptr;
+            if (__atomic_compare_exchange_n(&rings_[slot], &expected, ring, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                ring_count_.fetch_add(1, std::memory_order_release);
+                return ring;
+            }
+            slot++;
+        }
+        delete ring;
+        return nullptr;
+    }
+
+    static Ring* local_ring() {
+        thread_local RingOwner owner;
+        if (!owner.ring_) {
+            owner.ring_ = claim_ring();
+            if (owner.ring_) owner.ring_->thread_id_ = static_cast<uint32_t>(::syscall(SYS_gettid));
+        }
+        return owner.ring_;
+    }
+
+    static bool write_all(int fd, const void* data, size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t n = ::write(fd, p, bytes);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += n;
+            bytes -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // only open/write/close, so it can run inside a signal handler
+    static bool dump_to(const char* path) {
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+
+        size_t count = ring_count_.load(std::memory_order_acquire);
+        TraceFileHeader header{TRACE_MAGIC, TRACE_VERSION, static_cast<uint32_t>(count),
+                               static_cast<uint32_t>(RING_SIZE), static_cast<uint32_t>(::getpid()),
+                               CycleClock::ns_per_tick()};
+        bool ok = write_all(fd, &header, sizeof(header));
+        for (size_t i = 0; ok && i < count; i++) {
+            const Ring* ring = __atomic_load_n(&rings_[i], __ATOMIC_ACQUIRE);
+            TraceRingHeader ring_header{ring->head_.load(std::memory_order_acquire), ring->thread_id_, 0};
+            ok = write_all(fd, &ring_header, sizeof(ring_header))
+                 && write_all(fd, ring->events_, sizeof(ring->events_));
+        }
+        ok = ::close(fd) == 0 && ok;
+        return ok;
+    }
+
+    static void on_signal(int) {
+        int saved_errno = errno;
+        dump_to(signal_path_);
+        errno = saved_errno;
+    }
+
+public:
+    static void record(TraceOp op, uint64_t index, uint64_t start, uint64_t end, uint32_t retries) {
+        Ring* ring = local_ring();
+        if (!ring) return;
+        uint64_t head = ring->head_.load(std::memory_order_relaxed);
+        uint64_t duration = end - start;
+        ring->events_[head % RING_SIZE] = {start, index, static_cast<uint32_t>(std::min<uint64_t>(duration, UINT32_MAX)),
+                                           static_cast<uint16_t>(std::min<uint32_t>(retries, UINT16_MAX)),
+                                           static_cast<uint8_t>(op), 0};
+        ring->head_.store(head + 1, std::memory_order_release);
+    }
+
+    // a dump taken while threads are recording may contain a few half-written events
+    static void dump(const std::string& path) {
+        if (!dump_to(path.c_str())) {
+            throw std::system_error(errno, std::generic_category(), "trace dump");
+        }
+    }
+
+    // dumps to path whenever signo arrives, e.g. kill -USR2 <pid>
+    static void install_signal_handler(const std::string& path, int signo = SIGUSR2) {
+        if (path.size() >= sizeof(signal_path_)) throw std::length_error("trace path too long");
+        std::memcpy(signal_path_, path.c_str(), path.size() + 1);
+        CycleClock::ns_per_tick();   // calibrate now, not inside the handler
+
+        struct sigaction action = {};
+        action.sa_handler = on_signal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        if (::sigaction(signo, &action, nullptr) != 0) {
+            throw std::system_error(errno, std::generic_category(), "sigaction");
+        }
+    }
+};
+
+// records the enclosing operation when it ends; index and retries are filled in along the way
+class TraceScope {
+    TraceOp op_;
+    uint64_t start_;
+
+public:
+    uint64_t index_ = 0;
+    uint32_t retries_ = 0;
+
+    explicit TraceScope(TraceOp op) : op_(op), start_(CycleClock::now()) {}
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    ~TraceScope() { FlightRecorder::record(op_, index_, start_, CycleClock::now(), retries_); }
+};
+
+// events only get recorded in builds with LFV_TRACE defined, otherwise every hook is empty
+#ifdef LFV_TRACE
+#define LFV_TRACE_SCOPE(op) TraceScope lfv_trace_scope(TraceOp::op)
+#define LFV_TRACE_SET(index, retries) (lfv_trace_scope.index_ = (index), lfv_trace_scope.retries_ = static_cast<uint32_t>(retries))
+#define LFV_TRACE_EVENT(op, index) \
+    do { uint64_t lfv_now = CycleClock::now(); FlightRecorder::record(TraceOp::op, (index), lfv_now, lfv_now, 0); } while (0)
+#else
+#define LFV_TRACE_SCOPE(op) ((void)0)
+#define LFV_TRACE_SET(index, retries) ((void)0)
+#define LFV_TRACE_EVENT(op, index) ((void)0)
+#endif
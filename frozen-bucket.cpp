@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// read-only compressed copy of a full bucket of integers. elements are grouped in blocks of 128,
+// each block stores its minimum (frame of reference) and the bit width of the largest offset from
+// it, then the offsets are bit-packed back to back. any element is one header lookup and at most
+// two word loads away, so random access stays O(1). frame of reference is used instead of delta
+// coding because deltas would need a prefix sum to reach an element
+template <typename T>
+class FrozenBucket {
+private:
+    // non-integer T never gets frozen, the fallback only keeps the type instantiable
+    using U = typename std::conditional_t<std::is_integral_v<T>, std::make_unsigned<T>, std::type_identity<uint64_t>>::type;
+    static constexpr size_t BLOCK_SIZE = 128;
+    static constexpr size_t BITS = sizeof(T) * 8;
+
+    struct BlockHeader {
+        T base_;
+        uint32_t word_offset_;
+        uint8_t width_;
+    };
+
+    size_t count_;
+    size_t word_count_;
+    std::unique_ptr<BlockHeader[]> blocks_;
+    std::unique_ptr<uint64_t[]> words_;
+
+    static U mask(unsigned width) { return width >= BITS ? ~U(0) : static_cast<U>((U(1) << width) - 1); }
+
+    static U extract(const uint64_t* words, size_t bit, unsigned width) {
+        size_t w = bit >> 6;
+        unsigned s = bit & 63;
+        // the second word only matters when the value straddles a boundary; (x << 1) << (63 - s)
+        // is x << (64 - s) without the undefined shift by 64 when s == 0
+        uint64_t v = (words[w] >> s) | ((words[w + 1] << 1) << (63 - s));
+        return static_cast<U>(v) & mask(width);
+    }
+
+    // constant width lets the compiler unroll and vectorise the unpack loop
+    template <unsigned W>
+    static void decode_block(const uint64_t* words, T base, size_t n, T* out) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = static_cast<T>(static_cast<U>(base) + extract(words, i * W, W));
+        }
+    }
+
+    template <size_t... W>
+    static constexpr auto make_decoders(std::index_sequence<W...>) {
+        using Decoder = void (*)(const uint64_t*, T, size_t, T*);
+        return std::array<Decoder, sizeof...(W)>{&decode_block<static_cast<unsigned>(W)>...};
+    }
+
+    FrozenBucket() : count_(0), word_count_(0) {}
+
+public:
+    static std::unique_ptr<FrozenBucket> compress(const T* data, size_t count) {
+        static_assert(std::is_integral_v<T>, "only integer buckets can be frozen");
+
+        std::unique_ptr<FrozenBucket> frozen(new FrozenBucket());
+        size_t num_blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        frozen->count_ = count;
+        frozen->blocks_.reset(new BlockHeader[num_blocks]);
+
+        size_t total_words = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            size_t begin = b * BLOCK_SIZE;
+            size_t n = std::min(BLOCK_SIZE, count - begin);
+            T lo = data[begin], hi = data[begin];
+            for (size_t i = 1; i < n; i++) {
+                lo = std::min(lo, data[begin + i]);
+                hi = std::max(hi, data[begin + i]);
+            }
+            U range = static_cast<U>(static_cast<U>(hi) - static_cast<U>(lo));
+            unsigned width = range == 0 ? 0 : static_cast<unsigned>(64 - __builtin_clzll(static_cast<uint64_t>(range)));
+
+            frozen->blocks_[b] = {lo, static_cast<uint32_t>(total_words), static_cast<uint8_t>(width)};
+            total_words += (n * width + 63) / 64;
+        }
+
+        // one spare word so extract() can always read words[w + 1]
+        frozen->word_count_ = total_words + 1;
+        frozen->words_.reset(new uint64_t[frozen->word_count_]());
+
+        for (size_t b = 0; b < num_blocks; b++) {
+            const BlockHeader& header = frozen->blocks_[b];
+            uint64_t* words = frozen->words_.get() + header.word_offset_;
+            size_t begin = b * BLOCK_SIZE;
+            size_t n = std::min(BLOCK_SIZE, count - begin);
+            for (size_t i = 0; i < n && header.width_ > 0; i++) {
+                uint64_t v = static_cast<U>(static_cast<U>(data[begin + i]) - static_cast<U>(header.base_));
+                size_t bit = i * header.width_;
+                words[bit >> 6] |= v << (bit & 63);
+                if ((bit & 63) + header.width_ > 64) {
+                    words[(bit >> 6) + 1] |= v >> (64 - (bit & 63));
+                }
+            }
+        }
+        return frozen;
+    }
+
+    T get(size_t i) const {
+        const BlockHeader& header = blocks_[i / BLOCK_SIZE];
+        U offset = extract(words_.get() + header.word_offset_, (i % BLOCK_SIZE) * header.width_, header.width_);
+        return static_cast<T>(static_cast<U>(header.base_) + offset);
+    }
+
+    // bulk unpack used when a bucket is thawed
+    void decode(T* out) const {
+        static constexpr auto decoders = make_decoders(std::make_index_sequence<BITS + 1>{});
+        for (size_t begin = 0, b = 0; begin < count_; begin += BLOCK_SIZE, b++) {
+            const BlockHeader& header = blocks_[b];
+            decoders[header.width_](words_.get() + header.word_offset_, header.base_,
+                                    std::min(BLOCK_SIZE, count_ - begin), out + begin);
+        }
+    }
+
+    size_t size() const { return count_; }
+
+    size_t bytes() const {
+        return sizeof(*this) + ((count_ + BLOCK_SIZE - 1) / BLOCK_SIZE) * sizeof(BlockHeader)
+               + word_count_ * sizeof(uint64_t);
+    }
+};
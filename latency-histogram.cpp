@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// cheapest monotonic tick source available: the tsc on x86, clock_gettime elsewhere
+struct CycleClock {
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+    }
+
+    // measured once against steady_clock over ~10ms, assumes an invariant tsc
+    static double ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+        static const double ratio = [] {
+            auto wall_start = std::chrono::steady_clock::now();
+            uint64_t tick_start = now();
+            while (std::chrono::steady_clock::now() - wall_start < std::chrono::milliseconds(10)) {}
+            uint64_t ticks = now() - tick_start;
+            auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wall_start);
+            return ticks ? static_cast<double>(wall.count()) / static_cast<double>(ticks) : 1.0;
+        }();
+        return ratio;
+#else
+        return 1.0;
+#endif
+    }
+};
+
+// log-linear histogram of nanosecond values in the style of HdrHistogram: every power of two is
+// split into SUB_BUCKETS linear steps, so any recorded value is reported within 1/SUB_BUCKETS
+// (about 3%) of its true value. counters are relaxed atomics so one thread can record while
+// another merges or queries
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1UL << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_EXPONENT = 40;    // values past ~18 minutes are clamped
+    static constexpr size_t NUM_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+private:
+    std::atomic<uint64_t> counts_[NUM_BUCKETS] = {};
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> max_{0};
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        unsigned exponent = std::min(63u - static_cast<unsigned>(__builtin_clzll(value)), MAX_EXPONENT);
+        uint64_t sub = (std::min(value, (2UL << MAX_EXPONENT) - 1) >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>((exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub);
+    }
+
+    // largest value that lands in bucket
+    static uint64_t bucket_limit(size_t bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        unsigned exponent = static_cast<unsigned>(bucket / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+        uint64_t sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+    }
+
+public:
+    void record(uint64_t value) {
+        counts_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            if (uint64_t n = other.counts_[i].load(std::memory_order_relaxed)) {
+                counts_[i].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        total_.fetch_add(other.total_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        uint64_t other_max = other.max_.load(std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (other_max > max && !max_.compare_exchange_weak(max, other_max, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // value at or below which percent% of the samples fall, e.g. percentile(99.99)
+    uint64_t percentile(double percent) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(total) + 0.5);
+        rank = std::clamp<uint64_t>(rank, 1, total);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(bucket_limit(i), max());
+        }
+        return max();
+    }
+};
+
+enum class VectorOp { PUSH_BACK, POP_BACK, READ, WRITE, NUM_OPS };
+
+// one histogram per operation for every thread shard, shards are allocated on first use so a
+// vector only pays for the threads that actually touched it
+class LatencyRecorder {
+    static constexpr size_t SHARDS = 64;
+    static constexpr size_t NUM_OPS = static_cast<size_t>(VectorOp::NUM_OPS);
+
+    struct Shard {
+        LatencyHistogram ops_[NUM_OPS];
+    };
+
+    std::atomic<Shard*> shards_[SHARDS] = {};
+
+    // calibrated when the recorder is built, the first timed op would otherwise include the 10ms
+    double ns_per_tick_;
+
+    Shard& local_shard() {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        Shard* shard = shards_[index].load(std::memory_order_acquire);
+        if (!shard) {
+            Shard* fresh = new Shard();
+            if (shards_[index].compare_exchange_strong(shard, fresh, std::memory_order_acq_rel)) {
+                shard = fresh;
+            } else {
+                delete fresh;
+            }
+        }
+        return *shard;
+    }
+
+public:
+    LatencyRecorder() : ns_per_tick_(CycleClock::ns_per_tick()) {}
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    ~LatencyRecorder() {
+        for (auto& shard : shards_) {
+            delete shard.load();
+        }
+    }
+
+    void record(VectorOp op, uint64_t ticks) {
+        local_shard().ops_[static_cast<size_t>(op)].record(
+            static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick_));
+    }
+
+    // merges every thread's histogram for op, safe while other threads keep recording
+    void collect(VectorOp op, LatencyHistogram& out) const {
+        for (const auto& shard : shards_) {
+            if (const Shard* s = shard.load(std::memory_order_acquire)) {
+                out.merge(s->ops_[static_cast<size_t>(op)]);
+            }
+        }
+    }
+};
+
+// times the enclosing scope into recorder, including exits by exception
+class LatencyScope {
+    LatencyRecorder& recorder_;
+    VectorOp op_;
+    uint64_t start_;
+
+public:
+    LatencyScope(LatencyRecorder& recorder, VectorOp op)
+        : recorder_(recorder)
+        , op_(op)
+        , start_(CycleClock::now()) {}
+
+    LatencyScope(const LatencyScope&) = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+
+    ~LatencyScope() { recorder_.record(op_, CycleClock::now() - start_); }
+};
+
+// histograms only exist in builds with LFV_LATENCY defined, otherwise the hook is empty
+#ifdef LFV_LATENCY
+#define LFV_TIME_OP(op) LatencyScope lfv_latency_scope(latency_, VectorOp::op)
+#else
+#define LFV_TIME_OP(op) ((void)0)
+#endif
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// live statistics published to the shared-memory segment /lfv_stats_<pid>, where lfv_monitor
+// (or anything else) can read them without touching the process. a background thread samples
+// every registered vector and writes each slot under a seqlock: readers retry while the slot's
+// sequence is odd or changes underneath them, so neither side ever blocks the other
+
+static constexpr uint64_t LIVE_STATS_MAGIC = 0x3130545453564c46ULL; // "FLVSTT01"
+static constexpr uint32_t LIVE_STATS_VERSION = 1;
+static constexpr uint32_t LIVE_STATS_SLOTS = 64;
+
+// every field is an atomic so a reader in another process never sees a torn word
+struct LiveStatsSlot {
+    std::atomic<uint32_t> seq_;
+    std::atomic<uint32_t> in_use_;
+    char name_[56];
+    std::atomic<uint64_t> sampled_ns_;          // steady clock time of the sample
+    std::atomic<uint64_t> size_;
+    std::atomic<uint64_t> capacity_;            // elements the allocated buckets can hold
+    std::atomic<uint64_t> buckets_;
+    std::atomic<uint64_t> operations_;          // the counters below stay 0 without LFV_STATS
+    std::atomic<uint64_t> reads_;
+    std::atomic<uint64_t> writes_;
+    std::atomic<uint64_t> cas_attempts_;
+    std::atomic<uint64_t> cas_failures_;
+};
+
+struct LiveStatsSegment {
+    uint64_t magic_;
+    uint32_t version_;
+    uint32_t slot_count_;
+    uint32_t pid_;
+    uint32_t interval_ms_;
+    LiveStatsSlot slots_[LIVE_STATS_SLOTS];
+};
+
+// plain copy of one slot
+struct LiveStatsSample {
+    char name_[56];
+    uint64_t sampled_ns_;
+    uint64_t size_;
+    uint64_t capacity_;
+    uint64_t buckets_;
+    uint64_t operations_;
+    uint64_t reads_;
+    uint64_t writes_;
+    uint64_t cas_attempts_;
+    uint64_t cas_failures_;
+};
+
+inline std::string live_stats_segment_name(pid_t pid) {
+    return "/lfv_stats_" + std::to_string(pid);
+}
+
+// seqlock read, false when the slot is unused or stays mid-update for every attempt, which is
+// what a writer that died inside an update leaves behind
+inline bool read_live_stats(const LiveStatsSlot& slot, LiveStatsSample& out, int attempts = 1000) {
+    for (int attempt = 0; attempt < attempts; attempt++) {
+        uint32_t seq = slot.seq_.load(std::memory_order_acquire);
+        if (seq & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!slot.in_use_.load(std::memory_order_relaxed)) return false;
+        std::memcpy(out.name_, slot.name_, sizeof(out.name_));
+        out.name_[sizeof(out.name_) - 1] = '\0';
+        out.sampled_ns_ = slot.sampled_ns_.load(std::memory_order_relaxed);
+        out.size_ = slot.size_.load(std::memory_order_relaxed);
+        out.capacity_ = slot.capacity_.load(std::memory_order_relaxed);
+        out.buckets_ = slot.buckets_.load(std::memory_order_relaxed);
+        out.operations_ = slot.operations_.load(std::memory_order_relaxed);
+        out.reads_ = slot.reads_.load(std::memory_order_relaxed);
+        out.writes_ = slot.writes_.load(std::memory_order_relaxed);
+        out.cas_attempts_ = slot.cas_attempts_.load(std::memory_order_relaxed);
+        out.cas_failures_ = slot.cas_failures_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq_.load(std::memory_order_relaxed) == seq) return true;
+    }
+    return false;
+}
+
+// owns the segment and the sampling thread, created on the first registration
+class LiveStatsExporter {
+public:
+    using Sampler = std::function<void(LiveStatsSample&)>;
+
+private:
+    LiveStatsSegment* segment_ = nullptr;
+    std::string name_;
+    std::chrono::milliseconds interval_;
+
+    // guards samplers_ and is held for a whole sampling pass, so unregister() waits out a pass
+    // that is still looking at the vector
+    std::mutex mutex_;
+    std::condition_variable stop_cv_;
+    bool stopping_ = false;
+    Sampler samplers_[LIVE_STATS_SLOTS];
+    std::thread thread_;
+
+    explicit LiveStatsExporter(std::chrono::milliseconds interval)
+        : name_(live_stats_segment_name(::getpid()))
+        , interval_(interval) {
+        int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "shm_open");
+        if (::ftruncate(fd, sizeof(LiveStatsSegment)) != 0) {
+            int err = errno;
+            ::close(fd);
+            ::shm_unlink(name_.c_str());
+            throw std::system_error(err, std::generic_category(), "ftruncate");
+        }
+        void* p = ::mmap(nullptr, sizeof(LiveStatsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            ::shm_unlink(name_.c_str());
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        // a fresh segment is zero filled, so every slot starts unused
+        segment_ = static_cast<LiveStatsSegment*>(p);
+        segment_->version_ = LIVE_STATS_VERSION;
+        segment_->slot_count_ = LIVE_STATS_SLOTS;
+        segment_->pid_ = static_cast<uint32_t>(::getpid());
+        segment_->interval_ms_ = static_cast<uint32_t>(interval.count());
+        std::atomic_thread_fence(std::memory_order_release);
+        segment_->magic_ = LIVE_STATS_MAGIC;
+
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void publish(LiveStatsSlot& slot, const LiveStatsSample& sample) {
+        uint32_t seq = slot.seq_.load(std::memory_order_relaxed);
+        slot.seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.sampled_ns_.store(sample.sampled_ns_, std::memory_order_relaxed);
+        slot.size_.store(sample.size_, std::memory_order_relaxed);
+        slot.capacity_.store(sample.capacity_, std::memory_order_relaxed);
+        slot.buckets_.store(sample.buckets_, std::memory_order_relaxed);
+        slot.operations_.store(sample.operations_, std::memory_order_relaxed);
+        slot.reads_.store(sample.reads_, std::memory_order_relaxed);
+        slot.writes_.store(sample.writes_, std::memory_order_relaxed);
+        slot.cas_attempts_.store(sample.cas_attempts_, std::memory_order_relaxed);
+        slot.cas_failures_.store(sample.cas_failures_, std::memory_order_relaxed);
+        slot.seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            for (uint32_t i = 0; i < LIVE_STATS_SLOTS; i++) {
+                if (!samplers_[i]) continue;
+                LiveStatsSample sample = {};
+                samplers_[i](sample);
+                sample.sampled_ns_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+                publish(segment_->slots_[i], sample);
+            }
+            stop_cv_.wait_for(lock, interval_, [this] { return stopping_; });
+        }
+    }
+
+public:
+    // the first call fixes the sampling interval
+    static LiveStatsExporter& instance(std::chrono::milliseconds interval = std::chrono::milliseconds(100)) {
+        static LiveStatsExporter exporter(interval);
+        return exporter;
+    }
+
+    LiveStatsExporter(const LiveStatsExporter&) = delete;
+    LiveStatsExporter& operator=(const LiveStatsExporter&) = delete;
+
+    ~LiveStatsExporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        stop_cv_.notify_all();
+        thread_.join();
+        ::munmap(segment_, sizeof(LiveStatsSegment));
+        ::shm_unlink(name_.c_str());
+    }
+
+    // returns the slot now sampled for name
+    uint32_t register_sampler(const std::string& name, Sampler sampler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint32_t i = 0; i < LIVE_STATS_SLOTS; i++) {
+            if (samplers_[i]) continue;
+            samplers_[i] = std::move(sampler);
+            LiveStatsSlot& slot = segment_->slots_[i];
+            uint32_t seq = slot.seq_.load(std::memory_order_relaxed);
+            slot.seq_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memset(slot.name_, 0, sizeof(slot.name_));
+            std::strncpy(slot.name_, name.c_str(), sizeof(slot.name_) - 1);
+            slot.in_use_.store(1, std::memory_order_relaxed);
+            slot.seq_.store(seq + 2, std::memory_order_release);
+            return i;
+        }
+        throw std::runtime_error("no free live stats slot");
+    }
+
+    void unregister(uint32_t slot_index) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        samplers_[slot_index] = nullptr;
+        LiveStatsSlot& slot = segment_->slots_[slot_index];
+        uint32_t seq = slot.seq_.load(std::memory_order_relaxed);
+        slot.seq_.store(seq + 1, std::memory_order_relaxed);
+        slot.in_use_.store(0, std::memory_order_relaxed);
+        slot.seq_.store(seq + 2, std::memory_order_release);
+    }
+};
+
+// keeps one vector registered for as long as it lives
+class LiveStatsRegistration {
+    uint32_t slot_;
+
+public:
+    LiveStatsRegistration(const std::string& name, LiveStatsExporter::Sampler sampler)
+        : slot_(LiveStatsExporter::instance().register_sampler(name, std::move(sampler))) {}
+
+    LiveStatsRegistration(const LiveStatsRegistration&) = delete;
+    LiveStatsRegistration& operator=(const LiveStatsRegistration&) = delete;
+
+    ~LiveStatsRegistration() { LiveStatsExporter::instance().unregister(slot_); }
+};
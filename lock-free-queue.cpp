@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// unbounded mpmc fifo using the same doubling bucket layout as LockFreeVector.
+// producers and consumers take tickets with fetch_add on tail_/head_, ticket t lives in
+// the same (bucket, index) slot that position t would occupy in the vector.
+// tickets are never reused, so a queue serves at most MAX_TICKETS enqueues over its lifetime and
+// enqueue throws std::length_error after that. departed buckets are freed, but the bucket a
+// ticket lands in keeps doubling with the ticket count, so after about 1e9 operations every new
+// bucket is several GB no matter how short the queue is. meant for bounded runs, not long-lived
+// services
+template <typename T>
+class LockFreeQueue {
+private:
+    static constexpr uint32_t MAX_BUCKETS = 32;
+    static constexpr uint32_t FIRST_BUCKET_SIZE = 8;
+    // how long a consumer waits on a claimed-but-unwritten slot before abandoning it
+    static constexpr uint32_t SPIN_LIMIT = 128;
+
+public:
+    // tickets past this would map beyond the last bucket
+    static constexpr size_t MAX_TICKETS = FIRST_BUCKET_SIZE * ((1UL << MAX_BUCKETS) - 1);
+
+private:
+
+    enum SlotState : uint8_t {
+        EMPTY = 0,      // nobody has published here yet
+        FULL = 1,       // producer published value_
+        CONSUMED = 2,   // consumer took value_
+        ABANDONED = 3   // consumer gave up on the ticket, the producer must retry elsewhere
+    };
+
+    struct Slot {
+        std::atomic<uint8_t> state_{EMPTY};
+        T value_{};
+    };
+
+    std::atomic<Slot*> memory_[MAX_BUCKETS];
+
+    // every ticket is visited by exactly one producer and one consumer, once both have
+    // left all slots of a bucket it can be freed
+    std::atomic<size_t> departures_[MAX_BUCKETS];
+
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+
+    static size_t bucket_of(size_t ticket) {
+        size_t pos = ticket + FIRST_BUCKET_SIZE;
+        size_t hi_bit = __builtin_clzl(pos) ^ 63;
+        return hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
+    }
+
+    static size_t index_of(size_t ticket) {
+        size_t pos = ticket + FIRST_BUCKET_SIZE;
+        size_t hi_bit = __builtin_clzl(pos) ^ 63;
+        return pos ^ (1UL << hi_bit);
+    }
+
+    static size_t bucket_size(size_t bucket) { return FIRST_BUCKET_SIZE * (1UL << bucket); }
+
+    Slot* slot_for(size_t ticket) {
+        size_t bucket = bucket_of(ticket);
+        Slot* slots = memory_[bucket].load(std::memory_order_acquire);
+        if (!slots) {
+            allocate_bucket(bucket);
+            slots = memory_[bucket].load(std::memory_order_acquire);
+        }
+        return &slots[index_of(ticket)];
+    }
+
+    void allocate_bucket(size_t bucket) {
+        Slot* new_bucket = new Slot[bucket_size(bucket)];
+        Slot* expected = nullptr;
+
+        if (!memory_[bucket].compare_exchange_strong(expected, new_bucket)) {
+            delete[] new_bucket;
+        }
+    }
+
+    // called by each side once it no longer touches the slot for ticket
+    void depart(size_t ticket) {
+        size_t bucket = bucket_of(ticket);
+        if (departures_[bucket].fetch_add(1, std::memory_order_acq_rel) + 1 == 2 * bucket_size(bucket)) {
+            // no ticket maps to this bucket anymore, so nobody can reallocate it
+            delete[] memory_[bucket].exchange(nullptr, std::memory_order_acq_rel);
+        }
+    }
+
+public:
+    LockFreeQueue() : head_(0), tail_(0) {
+        memory_[0].store(new Slot[FIRST_BUCKET_SIZE]);
+        departures_[0].store(0);
+
+        for (size_t i = 1; i < MAX_BUCKETS; i++) {
+            memory_[i].store(nullptr);
+            departures_[i].store(0);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    ~LockFreeQueue() {
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            delete[] memory_[i].load();
+        }
+    }
+
+    void enqueue(const T& elem) {
+        while (true) {
+            size_t ticket = tail_.fetch_add(1, std::memory_order_acq_rel);
+            if (ticket >= MAX_TICKETS) {
+                throw std::length_error("queue ticket space exhausted");
+            }
+            Slot* slot = slot_for(ticket);
+
+            slot->value_ = elem;
+            uint8_t expected = EMPTY;
+            bool published = slot->state_.compare_exchange_strong(expected, FULL, std::memory_order_acq_rel);
+
+            // if the cas fails a consumer abandoned this ticket, take a new one
+            depart(ticket);
+            if (published) {
+                return;
+            }
+        }
+    }
+
+    bool try_dequeue(T& out) {
+        while (true) {
+            if (head_.load(std::memory_order_acquire) >= tail_.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            size_t ticket = head_.fetch_add(1, std::memory_order_acq_rel);
+            // only failed enqueues took tickets this far, nothing is ever published there
+            if (ticket >= MAX_TICKETS) {
+                return false;
+            }
+            Slot* slot = slot_for(ticket);
+
+            // a producer may hold the ticket without having published yet, give it a moment
+            uint8_t state = slot->state_.load(std::memory_order_acquire);
+            for (uint32_t spin = 0; state == EMPTY && spin < SPIN_LIMIT; spin++) {
+                state = slot->state_.load(std::memory_order_acquire);
+            }
+
+            if (state == EMPTY) {
+                uint8_t expected = EMPTY;
+                if (slot->state_.compare_exchange_strong(expected, ABANDONED, std::memory_order_acq_rel)) {
+                    depart(ticket);
+                    continue;
+                }
+                // lost the race to the producer, the value is there now
+            }
+
+            out = slot->value_;
+            slot->state_.store(CONSUMED, std::memory_order_release);
+            depart(ticket);
+            return true;
+        }
+    }
+
+    T dequeue() {
+        T value;
+        if (!try_dequeue(value)) {
+            throw std::out_of_range("empty");
+        }
+        return value;
+    }
+
+    // approximate while other threads are running
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+};
@@ -2,16 +2,65 @@
 // Created by Devang Jaiswal on 1/31/25.
 //
 
+// an include guard rather than #pragma once: CMake also builds this file as its own translation unit
+#ifndef LOCK_FREE_VECTOR_CPP
+#define LOCK_FREE_VECTOR_CPP
+
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <cerrno>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include "frozen-bucket.cpp"
+#include "snapshot.cpp"
+#include "vector-stats.cpp"
+#include "latency-histogram.cpp"
+#include "flight-recorder.cpp"
+#include "live-stats.cpp"
+#include "usdt-probes.cpp"
+
+// where bucket memory comes from. a storage policy provides:
+//   T* allocate_bucket(size_t bucket, size_t bucket_size)   zero/value-initialised memory
+//   void release_bucket(T* p, size_t bucket, size_t bucket_size)
+//   void recover(size_t& size, uint32_t& counter, T** buckets)   state left by a previous run
+//   void publish(size_t size, uint32_t counter)   called after every successful push/pop
+// and optionally
+//   std::pmr::memory_resource* descriptor_resource()   where descriptors are allocated, else new
 template <typename T>
+struct HeapStorage {
+    T* allocate_bucket(size_t, size_t bucket_size) { return new T[bucket_size](); }
+
+    void release_bucket(T* bucket, size_t, size_t) { delete[] bucket; }
+
+    void recover(size_t&, uint32_t&, T**) {}
+
+    void publish(size_t, uint32_t) {}
+};
+
+template <typename T, typename Storage = HeapStorage<T>>
 class LockFreeVector {
-private:
+public:
     static constexpr uint32_t MAX_BUCKETS = 32;
     static constexpr uint32_t FIRST_BUCKET_SIZE = 8;
 
+private:
+
     // holds pending write operations, we use this to ensure a prev write op has completed before starting another one
     struct WriteDescriptor {
         T* loc_;
@@ -45,47 +94,230 @@ private:
 
     std::atomic<Descriptor*> descriptor_;
 
+    Storage storage_;
+
+    // non-zero when a bucket is a mapping installed by load() rather than storage memory
+    size_t mapped_bytes_[MAX_BUCKETS] = {};
+
+    // buckets written since the last checkpoint
+    std::atomic<bool> dirty_[MAX_BUCKETS] = {};
+
+    // compressed copies of cold integer buckets, set while memory_[bucket] is null
+    std::atomic<FrozenBucket<T>*> frozen_[MAX_BUCKETS] = {};
+
+    // memory replaced by freeze/thaw that concurrent readers may still hold, freed by collect_retired()
+    struct RetiredBucket {
+        size_t bucket_;
+        T* memory_;
+        size_t mapped_bytes_;
+        FrozenBucket<T>* frozen_;
+    };
+    std::mutex retired_mutex_;
+    std::vector<RetiredBucket> retired_;
+
+    // tiering: full buckets evicted to tier_fd_ have a non-zero spill generation and a null memory_
+    // slot. accessed_ is the reference bit for the clock sweep that picks eviction victims
+    int tier_fd_ = -1;
+    size_t memory_budget_ = 0;
+    size_t clock_hand_ = 0;
+    uint32_t spill_generation_ = 0;
+    std::atomic<uint32_t> spilled_[MAX_BUCKETS] = {};
+    std::atomic<bool> accessed_[MAX_BUCKETS] = {};
+
+    // threads inside allocate_bucket per bucket. eviction and freezing leave such a bucket alone:
+    // a thread that saw the slot null before some other thread installed it could otherwise read
+    // the cold state from before a later eviction and install stale or zeroed memory
+    std::atomic<uint32_t> installing_[MAX_BUCKETS] = {};
+
+    // threads storing into a bucket's memory, see WritePin. an eviction or freeze marks the slot
+    // with RELEASING before it looks at the count and copies the bucket out; a writer that finds
+    // the mark clears it, which makes the final swap to null fail
+    std::atomic<uint32_t> writers_[MAX_BUCKETS] = {};
+    static constexpr uintptr_t RELEASING = uintptr_t(1) << 63;
+
+    static bool releasing(T* data) { return reinterpret_cast<uintptr_t>(data) & RELEASING; }
+    static T* unmarked(T* data) { return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(data) & ~RELEASING); }
+
+    struct ScopedCount {
+        std::atomic<uint32_t>& count_;
+        explicit ScopedCount(std::atomic<uint32_t>& count) : count_(count) { count_.fetch_add(1); }
+        ~ScopedCount() { count_.fetch_sub(1); }
+    };
+    using WritePin = ScopedCount;
+
+#ifdef LFV_STATS
+    StatsCounters stats_;
+#endif
+#ifdef LFV_LATENCY
+    LatencyRecorder latency_;
+#endif
+
+    std::unique_ptr<LiveStatsRegistration> live_stats_;
+
+    // descriptors are never reclaimed: every successful push/pop leaves one Descriptor and one
+    // WriteDescriptor behind. counting from the counter the current chain started at gives the
+    // total, abandoned_ holds what earlier chains (before a restore) left
+    uint32_t chain_start_counter_ = 0;
+    size_t abandoned_descriptors_ = 0;
+    size_t abandoned_write_descriptors_ = 0;
+
+    static size_t bucket_capacity(size_t bucket) { return FIRST_BUCKET_SIZE * (1UL << bucket); }
+
+    // descriptors come from the storage's descriptor resource when it has one
+    template <typename D, typename... Args>
+    D* new_descriptor(Args&&... args) {
+        LFV_COUNT(DESCRIPTOR_ALLOCATIONS);
+        if constexpr (requires { storage_.descriptor_resource(); }) {
+            void* p = storage_.descriptor_resource()->allocate(sizeof(D), alignof(D));
+            return new (p) D(std::forward<Args>(args)...);
+        } else {
+            return new D(std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename D>
+    void delete_descriptor(D* descriptor) {
+        if constexpr (requires { storage_.descriptor_resource(); }) {
+            descriptor->~D();
+            storage_.descriptor_resource()->deallocate(descriptor, sizeof(D), alignof(D));
+        } else {
+            delete descriptor;
+        }
+    }
+
+    void release_bucket(size_t bucket, T* memory) {
+        if (mapped_bytes_[bucket]) {
+            ::munmap(memory, mapped_bytes_[bucket]);
+            mapped_bytes_[bucket] = 0;
+        } else {
+            storage_.release_bucket(memory, bucket, bucket_capacity(bucket));
+        }
+    }
+
 public:
-    LockFreeVector() {
-        descriptor_.store(new Descriptor());
+    explicit LockFreeVector(Storage storage = Storage()) : storage_(std::move(storage)) {
+        size_t size = 0;
+        uint32_t counter = 0;
+        T* buckets[MAX_BUCKETS] = {};
+        storage_.recover(size, counter, buckets);
 
-        T* first_bucket = new T[FIRST_BUCKET_SIZE];
-        memory_[0].store(first_bucket);
+        descriptor_.store(new_descriptor<Descriptor>(size, counter));
+        chain_start_counter_ = counter;
 
-        for (size_t i = 1; i < MAX_BUCKETS; i++) {
-            memory_[i].store(nullptr);
+        if (!buckets[0]) {
+            buckets[0] = storage_.allocate_bucket(0, FIRST_BUCKET_SIZE);
+        }
+
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            memory_[i].store(buckets[i]);
         }
     }
 
-    // clz counts num of leading 0s starting from pos 31, substract 31 - num to get msb
+    ~LockFreeVector() {
+        live_stats_.reset();
+        collect_retired();
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            if (T* bucket = memory_[i].load()) {
+                release_bucket(i, bucket);
+            }
+            delete frozen_[i].load();
+        }
+        if (tier_fd_ >= 0) {
+            ::close(tier_fd_);
+        }
+    }
+
+    Storage& storage() { return storage_; }
+
+    // clz counts num of leading 0s starting from pos 31, substract 31 - num to get msb.
+    // stores through the reference are not seen by a concurrent eviction or freeze, use write()
     T& at(size_t position) {
         size_t pos = position + FIRST_BUCKET_SIZE;
         size_t hi_bit = __builtin_clz(pos) ^ 31;
         size_t bucket = hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
         size_t index = pos ^ (1UL << hi_bit);
-        return memory_[bucket].load()[index];
+        return bucket_memory(bucket)[index];
+    }
+
+    // a null bucket is unallocated, frozen or spilled, in every case the caller needs raw memory
+    T* bucket_memory(size_t bucket) {
+        touch(bucket);
+        T* data = memory_[bucket].load();
+        while (!data) {
+            allocate_bucket(bucket);
+            data = memory_[bucket].load();
+        }
+        return unmarked(data);
     }
 
     void allocate_bucket(size_t bucket) {
-        size_t bucket_size = FIRST_BUCKET_SIZE * (1 << bucket);
-        T* new_bucket = new T[bucket_size];
+        LFV_PROBE1(bucket_alloc_entry, bucket);
+
+        // announced before the slot is looked at again: an eviction or freeze either sees the count
+        // and skips the bucket, or has nulled the slot already and the cold state read below is its
+        ScopedCount installing(installing_[bucket]);
+        if (memory_[bucket].load()) {
+            LFV_PROBE2(bucket_alloc_return, bucket, 2);
+            return;
+        }
+
+        size_t bucket_size = FIRST_BUCKET_SIZE * (1UL << bucket);
+        T* new_bucket = storage_.allocate_bucket(bucket, bucket_size);
+        LFV_COUNT(BUCKET_ALLOCATIONS);
+
+        // writing to a frozen bucket thaws it back into raw memory
+        FrozenBucket<T>* frozen = frozen_[bucket].load();
+        if constexpr (std::is_integral_v<T>) {
+            if (frozen) {
+                frozen->decode(new_bucket);
+            }
+        }
+
+        // touching a spilled bucket faults it back in from the tier file
+        uint32_t spilled = spilled_[bucket].load();
+        if (spilled) {
+            try {
+                read_tier(bucket, new_bucket);
+            } catch (...) {
+                storage_.release_bucket(new_bucket, bucket, bucket_size);
+                throw;
+            }
+        }
 
         T* expected = nullptr;
 
         // if we already have a bucket at the location we want to allocate, delete
         if (!memory_[bucket].compare_exchange_strong(expected, new_bucket)) {
-            delete[] new_bucket;
+            LFV_COUNT(BUCKET_ALLOCATION_RACES);
+            LFV_TRACE_EVENT(BUCKET_ALLOCATION_RACE, bucket);
+            storage_.release_bucket(new_bucket, bucket, bucket_size);
+            LFV_PROBE2(bucket_alloc_return, bucket, 0);
+            return;
+        }
+
+        LFV_TRACE_EVENT(BUCKET_ALLOCATION, bucket);
+        LFV_PROBE2(bucket_alloc_return, bucket, 1);
+        if (frozen && frozen_[bucket].compare_exchange_strong(frozen, nullptr)) {
+            retire({bucket, nullptr, 0, frozen});
+        } else if (spilled) {
+            // a later eviction starts a new generation, so a stale clear cannot hide it
+            spilled_[bucket].compare_exchange_strong(spilled, 0);
         }
     }
 
 
-    void push_back(const T& elem) {
-        while (true) {
+    // returns the position the element was stored at
+    size_t push_back(const T& elem) {
+        LFV_TIME_OP(PUSH_BACK);
+        LFV_PROBE0(push_entry);
+        LFV_TRACE_SCOPE(PUSH_BACK);
+        for (uint64_t retries = 0; ; retries++) {
 
             Descriptor* current_desc = descriptor_.load();
 
-            if (current_desc->pending_write_) {
-                complete_write(current_desc->pending_write_);
+            if (current_desc->pending_write_ && complete_write(current_desc->pending_write_)) {
+                LFV_COUNT(HELPED_WRITES);
+                LFV_PROBE1(help, current_desc->pending_write_->loc_);
             }
 
             size_t new_size = current_desc->size_ + 1;
@@ -95,35 +327,45 @@ public:
             size_t bucket = hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
             size_t index = pos ^ (1UL << hi_bit);
 
+            // pinned until the element is stored, helpers can only store it before complete_write returns
+            WritePin pin(writers_[bucket]);
             // allocate a new bucket if needed
-            if (!memory_[bucket].load()) {
-                allocate_bucket(bucket);
-            }
-
-            T* target_loc = &(memory_[bucket].load()[index]);
+            T* target_loc = &(writable_memory(bucket)[index]);
 
             // the current write operation we are doing
-            WriteDescriptor* write_operation = new WriteDescriptor(target_loc, T(), elem);
+            WriteDescriptor* write_operation = new_descriptor<WriteDescriptor>(target_loc, T(), elem);
             // new descriptor object with the current write op we are doing
-            Descriptor* new_desc = new Descriptor(new_size, current_desc->counter_ + 1, write_operation);
+            Descriptor* new_desc = new_descriptor<Descriptor>(new_size, current_desc->counter_ + 1, write_operation);
 
+            LFV_COUNT(DESCRIPTOR_CAS_ATTEMPTS);
             if (descriptor_.compare_exchange_strong(current_desc, new_desc)) {
                 complete_write(write_operation);
-                break;
+                mark_dirty(bucket);
+                storage_.publish(new_size, new_desc->counter_);
+                LFV_RECORD_OPERATION(retries);
+                LFV_TRACE_SET(current_desc->size_, retries);
+                LFV_PROBE2(push_return, current_desc->size_, retries);
+                return current_desc->size_;
             }
+            LFV_COUNT(DESCRIPTOR_CAS_FAILURES);
+            LFV_PROBE2(cas_fail, 0, retries);
 
-            delete write_operation;
-            delete new_desc;
+            delete_descriptor(write_operation);
+            delete_descriptor(new_desc);
 
         }
     }
 
     T pop_back() {
-        while (true) {
+        LFV_TIME_OP(POP_BACK);
+        LFV_PROBE0(pop_entry);
+        LFV_TRACE_SCOPE(POP_BACK);
+        for (uint64_t retries = 0; ; retries++) {
 
             Descriptor* current_desc = descriptor_.load();
-            if (current_desc->pending_write_) {
-                complete_write(current_desc->pending_write_);
+            if (current_desc->pending_write_ && complete_write(current_desc->pending_write_)) {
+                LFV_COUNT(HELPED_WRITES);
+                LFV_PROBE1(help, current_desc->pending_write_->loc_);
             }
 
             if (current_desc->size_ == 0) {
@@ -135,28 +377,38 @@ public:
             size_t bucket = hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
             size_t index = pos ^ (1UL << hi_bit);
 
-            T* target_addr = &(memory_[bucket].load()[index]);
+            WritePin pin(writers_[bucket]);
+            T* target_addr = &(writable_memory(bucket)[index]);
 
             T value = *target_addr;
 
-            WriteDescriptor* write_op = new WriteDescriptor(target_addr,
+            WriteDescriptor* write_op = new_descriptor<WriteDescriptor>(target_addr,
                                                       value,
                                                       T());
 
-            Descriptor* new_desc = new Descriptor(current_desc->size_ - 1, current_desc->counter_ + 1, write_op);
+            Descriptor* new_desc = new_descriptor<Descriptor>(current_desc->size_ - 1, current_desc->counter_ + 1, write_op);
 
+            LFV_COUNT(DESCRIPTOR_CAS_ATTEMPTS);
             if (descriptor_.compare_exchange_strong(current_desc, new_desc)) {
                 complete_write(write_op);
+                mark_dirty(bucket);
+                storage_.publish(new_desc->size_, new_desc->counter_);
+                LFV_RECORD_OPERATION(retries);
+                LFV_TRACE_SET(new_desc->size_, retries);
+                LFV_PROBE2(pop_return, new_desc->size_, retries);
                 return value;
             }
+            LFV_COUNT(DESCRIPTOR_CAS_FAILURES);
+            LFV_PROBE2(cas_fail, 1, retries);
 
-            delete write_op;
+            delete_descriptor(write_op);
 
-            delete new_desc;
+            delete_descriptor(new_desc);
         }
     }
 
-    void complete_write(WriteDescriptor* write_op) {
+    // returns true when this call was the one that stored the value
+    bool complete_write(WriteDescriptor* write_op) {
         if (write_op && !write_op->completed_) {
             // get the location of the pending write op
             std::atomic<T>* atomic_loc = reinterpret_cast<std::atomic<T>*>(write_op->loc_);
@@ -164,6 +416,7 @@ public:
 
             if (atomic_loc->compare_exchange_strong(expected, write_op->new_val_)) {
                 write_op->completed_ = true;
+                return true;
             }
 
             // if the cas fails, another thread already completed the write op
@@ -171,25 +424,642 @@ public:
                 write_op->completed_ = true;
             }
         }
+        return false;
     }
 
 
 
-    T read(const size_t i) { return at(i); }
+    T read(const size_t i) {
+        LFV_TIME_OP(READ);
+        LFV_COUNT(READS);
+        size_t pos = i + FIRST_BUCKET_SIZE;
+        size_t hi_bit = __builtin_clz(pos) ^ 31;
+        size_t bucket = hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
+        size_t index = pos ^ (1UL << hi_bit);
+
+        touch(bucket);
+        if (T* data = memory_[bucket].load()) {
+            return unmarked(data)[index];
+        }
+        return read_cold(bucket, index);
+    }
 
     void write(const size_t i, const T& elem) {
+        LFV_TIME_OP(WRITE);
+        LFV_COUNT(WRITES);
+        LFV_TRACE_SCOPE(WRITE);
+        LFV_TRACE_SET(i, 0);
         size_t pos = i + FIRST_BUCKET_SIZE;
         size_t hi_bit = __builtin_clz(pos) ^ 31;
         size_t bucket = hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
         size_t index = pos ^ (1UL << hi_bit);
 
-        T* target = &(memory_[bucket].load()[index]);
+        WritePin pin(writers_[bucket]);
+        T* target = &(writable_memory(bucket)[index]);
         std::atomic<T>* atomic_target = reinterpret_cast<std::atomic<T>*>(target);
 
-        atomic_target->store(elem, std::memory_order_release);
+        // seq_cst so the dirty flag check cannot move ahead of the store
+        atomic_target->store(elem, std::memory_order_seq_cst);
+        mark_dirty(bucket);
     }
 
 
     size_t size() const { return descriptor_.load()->size_; }
 
-};
\ No newline at end of file
+    // size() once the pending write of the operation that set it has landed. size() alone can
+    // count a pushed element whose value is not stored yet, reading it then returns T()
+    size_t completed_size() {
+        Descriptor* desc = descriptor_.load();
+        if (desc->pending_write_) {
+            complete_write(desc->pending_write_);
+        }
+        return desc->size_;
+    }
+
+    // replaces a full bucket of integers with its compressed form, reads keep working through
+    // read() while writes thaw it again. returns false when the bucket was written while it was
+    // being compressed, and the raw memory is only returned by collect_retired()
+    bool freeze_bucket(size_t bucket) requires std::is_integral_v<T> {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+
+        T* data = memory_[bucket].load();
+        if (!data || frozen_[bucket].load() || installing_[bucket].load()
+            || descriptor_.load()->size_ < (bucket_capacity(bucket + 1) - FIRST_BUCKET_SIZE)) {
+            return false;
+        }
+
+        T* marked = mark_releasing(bucket, data);
+        if (!marked) return false;
+        FrozenBucket<T>* frozen;
+        try {
+            frozen = FrozenBucket<T>::compress(data, bucket_capacity(bucket)).release();
+        } catch (...) {
+            memory_[bucket].compare_exchange_strong(marked, data);
+            throw;
+        }
+        frozen_[bucket].store(frozen);
+        // fails when a writer cleared the mark, its store may be missing from the compressed copy
+        if (!memory_[bucket].compare_exchange_strong(marked, nullptr)) {
+            frozen_[bucket].store(nullptr);
+            delete frozen;
+            return false;
+        }
+
+        retired_.push_back({bucket, data, mapped_bytes_[bucket], nullptr});
+        mapped_bytes_[bucket] = 0;
+        return true;
+    }
+
+    // freezes every full bucket except the newest keep_hot ones, returns how many were frozen
+    size_t freeze_cold_buckets(size_t keep_hot = 1) requires std::is_integral_v<T> {
+        size_t full = 0;
+        while (full < MAX_BUCKETS && bucket_capacity(full + 1) - FIRST_BUCKET_SIZE <= size()) {
+            full++;
+        }
+
+        size_t frozen = 0;
+        for (size_t i = 0; i + keep_hot < full; i++) {
+            frozen += freeze_bucket(i);
+        }
+        return frozen;
+    }
+
+    // frees memory retired by freeze/thaw. only call when no other thread is inside an operation
+    void collect_retired() {
+        std::vector<RetiredBucket> retired;
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            retired.swap(retired_);
+        }
+        for (const RetiredBucket& entry : retired) {
+            if (entry.memory_ && entry.mapped_bytes_) {
+                ::munmap(entry.memory_, entry.mapped_bytes_);
+            } else if (entry.memory_) {
+                storage_.release_bucket(entry.memory_, entry.bucket_, bucket_capacity(entry.bucket_));
+            }
+            delete entry.frozen_;
+        }
+    }
+
+    // spills least recently touched full buckets to a scratch file at path whenever resident bucket
+    // memory exceeds budget_bytes; touching a spilled bucket faults it back in. the file is unlinked
+    // right away and only lives as long as the vector. call before the vector is shared
+    void enable_tiering(const std::string& path, size_t budget_bytes) {
+        static_assert(std::is_trivially_copyable_v<T>, "tiering stores raw bytes of T");
+
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) throw_snapshot_errno("open");
+        ::unlink(path.c_str());
+        if (tier_fd_ >= 0) ::close(tier_fd_);
+        tier_fd_ = fd;
+        memory_budget_ = budget_bytes;
+    }
+
+    // clock sweep over the full buckets until resident memory fits the budget: a bucket touched
+    // since the hand last passed gets a second chance, so the sweep goes round at most twice.
+    // returns the number evicted. evicted memory is retired, so it is only returned once collect_retired() runs.
+    // a bucket that is written while it is copied out stays resident and is retried on a later pass
+    size_t enforce_memory_budget() {
+        if (tier_fd_ < 0) return 0;
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+
+        // the bucket holding the next push stays resident
+        size_t full = 0;
+        while (full < MAX_BUCKETS && bucket_capacity(full + 1) - FIRST_BUCKET_SIZE <= size()) {
+            full++;
+        }
+        if (full == 0) return 0;
+
+        size_t evicted = 0;
+        for (size_t step = 0; step < 2 * full && resident_bytes() > memory_budget_; step++) {
+            size_t bucket = clock_hand_++ % full;
+            T* data = memory_[bucket].load();
+            if (!data || mapped_bytes_[bucket] || installing_[bucket].load()) continue;
+            if (accessed_[bucket].exchange(false)) continue;
+
+            T* marked = mark_releasing(bucket, data);
+            if (!marked) continue;
+            try {
+                write_tier(bucket, data);
+            } catch (...) {
+                memory_[bucket].compare_exchange_strong(marked, data);
+                throw;
+            }
+            if (++spill_generation_ == 0) spill_generation_ = 1;
+            spilled_[bucket].store(spill_generation_);
+            // fails when a writer cleared the mark, its store may be missing from the tier file
+            if (!memory_[bucket].compare_exchange_strong(marked, nullptr)) {
+                spilled_[bucket].store(0);
+                continue;
+            }
+            retired_.push_back({bucket, data, 0, nullptr});
+            evicted++;
+        }
+        return evicted;
+    }
+
+    // bucket memory reachable from the vector, retired buckets are not counted
+    size_t resident_bytes() const {
+        size_t bytes = 0;
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            if (memory_[i].load()) {
+                bytes += bucket_capacity(i) * sizeof(T);
+            }
+        }
+        return bytes + frozen_bytes();
+    }
+
+    // publishes this vector's stats under name in the process's live stats segment until the
+    // vector is destroyed, see lfv_monitor. op counters need LFV_STATS, the rest is always there
+    void export_live_stats(const std::string& name) {
+        live_stats_.reset();
+        live_stats_ = std::make_unique<LiveStatsRegistration>(name, [this](LiveStatsSample& sample) {
+            sample.size_ = size();
+            for (size_t i = 0; i < MAX_BUCKETS; i++) {
+                if (memory_[i].load() || frozen_[i].load() || spilled_[i].load()) {
+                    sample.capacity_ += bucket_capacity(i);
+                    sample.buckets_++;
+                }
+            }
+            VectorStats counters = stats();
+            sample.operations_ = counters.operations_;
+            sample.reads_ = counters.reads_;
+            sample.writes_ = counters.writes_;
+            sample.cas_attempts_ = counters.descriptor_cas_attempts_;
+            sample.cas_failures_ = counters.descriptor_cas_failures_;
+        });
+    }
+
+    // where this vector's memory goes, per bucket and in total. only exact while the vector is
+    // quiescent, under concurrent pushes the numbers can straddle a change
+    MemoryStats memory_stats() {
+        MemoryStats stats;
+        size_t size = this->size();
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            BucketMemoryStats& bucket = stats.buckets_[i];
+            bucket.capacity_ = bucket_capacity(i);
+            size_t first = bucket_capacity(i) - FIRST_BUCKET_SIZE;
+            bucket.used_ = size > first ? std::min(size - first, bucket.capacity_) : 0;
+
+            if (memory_[i].load()) {
+                bucket.state_ = mapped_bytes_[i] ? BucketState::MAPPED : BucketState::RAW;
+                bucket.resident_bytes_ = bucket.capacity_ * sizeof(T);
+                stats.bucket_bytes_ += bucket.resident_bytes_;
+                if (bucket.used_ < bucket.capacity_) {
+                    stats.slack_bytes_ += (bucket.capacity_ - bucket.used_) * sizeof(T);
+                }
+            } else if (const FrozenBucket<T>* frozen = frozen_[i].load()) {
+                bucket.state_ = BucketState::FROZEN;
+                bucket.resident_bytes_ = frozen->bytes();
+                stats.frozen_bytes_ += bucket.resident_bytes_;
+            } else if (spilled_[i].load()) {
+                bucket.state_ = BucketState::SPILLED;
+                stats.spilled_bytes_ += bucket.capacity_ * sizeof(T);
+            }
+        }
+        stats.live_bytes_ = size * sizeof(T);
+
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            for (const RetiredBucket& entry : retired_) {
+                if (entry.memory_) stats.retired_bytes_ += bucket_capacity(entry.bucket_) * sizeof(T);
+                if (entry.frozen_) stats.retired_bytes_ += entry.frozen_->bytes();
+            }
+        }
+
+        uint32_t ops = descriptor_.load()->counter_ - chain_start_counter_;
+        size_t write_descriptors = abandoned_write_descriptors_ + ops;
+        stats.descriptors_ = abandoned_descriptors_ + 1 + ops;
+        stats.descriptor_bytes_ = stats.descriptors_ * sizeof(Descriptor) + write_descriptors * sizeof(WriteDescriptor);
+        return stats;
+    }
+
+    // sums the per-thread counters, all zero unless built with LFV_STATS
+    VectorStats stats() const {
+#ifdef LFV_STATS
+        return stats_.collect();
+#else
+        return VectorStats();
+#endif
+    }
+
+    // merges every thread's latency histogram for op into out, which stays empty unless built
+    // with LFV_LATENCY
+    void latency(VectorOp op, LatencyHistogram& out) const {
+#ifdef LFV_LATENCY
+        latency_.collect(op, out);
+#else
+        (void)op;
+        (void)out;
+#endif
+    }
+
+    // bytes held by frozen buckets, raw buckets take bucket capacity * sizeof(T)
+    size_t frozen_bytes() const {
+        size_t bytes = 0;
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            if (const FrozenBucket<T>* frozen = frozen_[i].load()) {
+                bytes += frozen->bytes();
+            }
+        }
+        return bytes;
+    }
+
+    // writes the current contents with one pwritev, each bucket contiguous and checksummed, to a
+    // temporary file that then replaces path. concurrent writers are not blocked, but the snapshot
+    // is only exact when the vector is quiescent
+    void save(const std::string& path) {
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            dirty_[i].store(false, std::memory_order_seq_cst);
+        }
+        write_snapshot(path, false);
+    }
+
+    // replaces the contents with a snapshot. buckets are private mappings of the file, so nothing
+    // is copied up front and pages are only duplicated once written. must not race other operations
+    void load(const std::string& path, bool verify = true) {
+        T* buckets[MAX_BUCKETS] = {};
+        size_t mapped[MAX_BUCKETS] = {};
+        SnapshotHeader header = map_snapshot(path, verify, buckets, mapped);
+
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            install_bucket(i, buckets[i], mapped[i]);
+        }
+        finish_restore(header);
+    }
+
+    // persists buckets written since the previous checkpoint. the manifest at manifest_path lists a
+    // base snapshot followed by deltas that each hold only the buckets dirtied in between; the first
+    // checkpoint (or full = true) starts a new chain and removes the files of the old one. returns
+    // the file written
+    std::string checkpoint(const std::string& manifest_path, bool full = false) {
+        std::vector<std::string> previous;
+        {
+            std::ifstream in(manifest_path);
+            for (std::string line; std::getline(in, line); ) {
+                if (!line.empty()) previous.push_back(line);
+            }
+        }
+
+        // chain files are numbered on from the previous chain and never rewritten, so until the new
+        // manifest is in place every file the old one names is intact, even if it is mapped
+        std::string prefix = manifest_path + ".";
+        uint64_t next = 0;
+        for (const std::string& entry : previous) {
+            if (entry.rfind(prefix, 0) == 0) {
+                next = std::max<uint64_t>(next, std::strtoull(entry.c_str() + prefix.size(), nullptr, 10) + 1);
+            }
+        }
+        std::vector<std::string> chain;
+        if (!full) chain = previous;
+
+        // both are fsynced before they return
+        std::string file = prefix + std::to_string(next);
+        if (chain.empty()) {
+            save(file);
+        } else {
+            write_snapshot(file, true);
+        }
+        chain.push_back(file);
+
+        // the manifest is replaced atomically so a crash mid-checkpoint keeps the previous chain
+        std::string text;
+        for (const std::string& entry : chain) {
+            text += entry + '\n';
+        }
+        std::vector<iovec> iov{{text.data(), text.size()}};
+        snapshot_replace_file(manifest_path, iov);
+
+        if (chain.size() == 1) {
+            for (const std::string& entry : previous) {
+                ::unlink(entry.c_str());
+            }
+        }
+        return file;
+    }
+
+    // loads the base snapshot and lays every delta over it, a bucket from a later file replaces the
+    // earlier mapping wholesale. must not race other operations
+    void restore(const std::string& manifest_path, bool verify = true) {
+        std::ifstream in(manifest_path);
+        if (!in) throw std::runtime_error("missing checkpoint manifest");
+
+        std::vector<std::string> chain;
+        for (std::string line; std::getline(in, line); ) {
+            if (!line.empty()) chain.push_back(line);
+        }
+        if (chain.empty()) throw std::runtime_error("empty checkpoint manifest");
+
+        load(chain.front(), verify);
+        for (size_t f = 1; f < chain.size(); f++) {
+            T* buckets[MAX_BUCKETS] = {};
+            size_t mapped[MAX_BUCKETS] = {};
+            SnapshotHeader header = map_snapshot(chain[f], verify, buckets, mapped);
+
+            for (size_t i = 0; i < MAX_BUCKETS; i++) {
+                if (buckets[i]) install_bucket(i, buckets[i], mapped[i]);
+            }
+            finish_restore(header);
+        }
+    }
+
+private:
+    // memory for a store into bucket by a thread holding a WritePin on it. clears an eviction's or
+    // freeze's mark, the copy it is making could be missing the store
+    T* writable_memory(size_t bucket) {
+        touch(bucket);
+        T* data = memory_[bucket].load();
+        while (true) {
+            if (releasing(data)) {
+                if (memory_[bucket].compare_exchange_strong(data, unmarked(data))) return unmarked(data);
+            } else if (data) {
+                return data;
+            } else {
+                allocate_bucket(bucket);
+                data = memory_[bucket].load();
+            }
+        }
+    }
+
+    // marks the slot so that writers announce themselves, returns the marked pointer or null when
+    // a writer is already inside the bucket. the mark goes in before the count is read and a writer
+    // pins before it loads the slot, so one of the two always sees the other
+    T* mark_releasing(size_t bucket, T* data) {
+        T* marked = reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(data) | RELEASING);
+        if (!memory_[bucket].compare_exchange_strong(data, marked)) return nullptr;
+        if (writers_[bucket].load()) {
+            memory_[bucket].compare_exchange_strong(marked, data);
+            return nullptr;
+        }
+        return marked;
+    }
+
+    void touch(size_t bucket) {
+        if (tier_fd_ >= 0 && !accessed_[bucket].load(std::memory_order_relaxed)) {
+            accessed_[bucket].store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // buckets sit back to back in the tier file at the same offsets as in an unbounded array
+    static off_t tier_offset(size_t bucket) {
+        return static_cast<off_t>((bucket_capacity(bucket) - FIRST_BUCKET_SIZE) * sizeof(T));
+    }
+
+    void write_tier(size_t bucket, const T* data) {
+        const char* p = reinterpret_cast<const char*>(data);
+        size_t bytes = bucket_capacity(bucket) * sizeof(T);
+        off_t offset = tier_offset(bucket);
+        while (bytes > 0) {
+            ssize_t n = ::pwrite(tier_fd_, p, bytes, offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw_snapshot_errno("pwrite");
+            }
+            p += n;
+            bytes -= static_cast<size_t>(n);
+            offset += n;
+        }
+    }
+
+    void read_tier(size_t bucket, T* data) {
+        char* p = reinterpret_cast<char*>(data);
+        size_t bytes = bucket_capacity(bucket) * sizeof(T);
+        off_t offset = tier_offset(bucket);
+        while (bytes > 0) {
+            ssize_t n = ::pread(tier_fd_, p, bytes, offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw_snapshot_errno("pread");
+            }
+            if (n == 0) throw std::runtime_error("tier file truncated");
+            p += n;
+            bytes -= static_cast<size_t>(n);
+            offset += n;
+        }
+    }
+
+    void retire(const RetiredBucket& entry) {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        retired_.push_back(entry);
+    }
+
+    // the bucket is frozen or spilled, or a freeze/thaw/eviction is switching it over
+    T read_cold(size_t bucket, size_t index) {
+        while (true) {
+            if (T* data = memory_[bucket].load()) {
+                return unmarked(data)[index];
+            }
+            if constexpr (std::is_integral_v<T>) {
+                if (FrozenBucket<T>* frozen = frozen_[bucket].load()) {
+                    return frozen->get(index);
+                }
+            }
+            if (!memory_[bucket].load()) {
+                allocate_bucket(bucket);
+            }
+        }
+    }
+
+    // set after the element is written so that a checkpoint, which clears the flag before copying,
+    // either sees the write or leaves the bucket dirty for the next one
+    void mark_dirty(size_t bucket) {
+        if (!dirty_[bucket].load(std::memory_order_seq_cst)) {
+            dirty_[bucket].store(true, std::memory_order_release);
+        }
+    }
+
+    // with only_dirty set, buckets that were not written since the last checkpoint are left out
+    // of the file and recorded with offset 0
+    void write_snapshot(const std::string& path, bool only_dirty) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshots store raw bytes of T");
+
+        Descriptor* desc = descriptor_.load();
+        if (desc->pending_write_) {
+            complete_write(desc->pending_write_);
+        }
+
+        size_t alignment = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t bucket_count = 0;
+        for (size_t covered = 0; covered < desc->size_ || bucket_count == 0; bucket_count++) {
+            covered += bucket_capacity(bucket_count);
+        }
+        if (only_dirty) {
+            // pops can leave dirty buckets above the current size
+            for (size_t i = bucket_count; i < MAX_BUCKETS; i++) {
+                if (dirty_[i].load() && memory_[i].load()) bucket_count = i + 1;
+            }
+        }
+
+        SnapshotHeader header{SNAPSHOT_MAGIC, SNAPSHOT_VERSION, static_cast<uint32_t>(sizeof(T)),
+                              desc->size_, desc->counter_, static_cast<uint32_t>(bucket_count), alignment};
+        std::vector<SnapshotBucket> table(bucket_count);
+        std::vector<iovec> iov;
+        std::vector<char> padding(alignment, 0);
+        std::vector<std::unique_ptr<T[]>> thawed;
+
+        size_t offset = sizeof(header) + bucket_count * sizeof(SnapshotBucket);
+        size_t remaining = desc->size_;
+        iov.push_back({&header, sizeof(header)});
+        iov.push_back({table.data(), bucket_count * sizeof(SnapshotBucket)});
+
+        for (size_t i = 0; i < bucket_count; i++) {
+            size_t elems = std::min(remaining, bucket_capacity(i));
+            remaining -= elems;
+            if (only_dirty && !dirty_[i].exchange(false, std::memory_order_seq_cst)) {
+                table[i] = {0, 0, 0};
+                continue;
+            }
+
+            size_t pad = (alignment - offset % alignment) % alignment;
+            if (pad) iov.push_back({padding.data(), pad});
+            offset += pad;
+
+            T* data = unmarked(memory_[i].load());
+            if constexpr (std::is_integral_v<T>) {
+                FrozenBucket<T>* frozen = frozen_[i].load();
+                if (!data && frozen) {
+                    thawed.emplace_back(new T[bucket_capacity(i)]);
+                    frozen->decode(thawed.back().get());
+                    data = thawed.back().get();
+                }
+            }
+            if (!data && spilled_[i].load()) {
+                thawed.emplace_back(new T[bucket_capacity(i)]);
+                read_tier(i, thawed.back().get());
+                data = thawed.back().get();
+            }
+            table[i] = {offset, elems * sizeof(T), snapshot_checksum(data, elems * sizeof(T))};
+            if (elems) iov.push_back({data, elems * sizeof(T)});
+            offset += elems * sizeof(T);
+        }
+
+        // never written in place: path may be the file this vector's buckets are mapped from
+        snapshot_replace_file(path, iov);
+    }
+
+    // maps every bucket stored in path; buckets absent from a delta are left null
+    SnapshotHeader map_snapshot(const std::string& path, bool verify, T** buckets, size_t* mapped) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshots store raw bytes of T");
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw_snapshot_errno("open");
+
+        SnapshotHeader header;
+        std::vector<SnapshotBucket> table;
+        try {
+            struct stat st;
+            if (::fstat(fd, &st) != 0) throw_snapshot_errno("fstat");
+            if (::pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+                || header.magic_ != SNAPSHOT_MAGIC || header.version_ != SNAPSHOT_VERSION
+                || header.elem_size_ != sizeof(T) || header.bucket_count_ == 0 || header.bucket_count_ > MAX_BUCKETS
+                || header.alignment_ % static_cast<size_t>(::sysconf(_SC_PAGESIZE)) != 0) {
+                throw std::runtime_error("snapshot header mismatch");
+            }
+
+            table.resize(header.bucket_count_);
+            size_t table_bytes = table.size() * sizeof(SnapshotBucket);
+            if (::pread(fd, table.data(), table_bytes, sizeof(header)) != static_cast<ssize_t>(table_bytes)) {
+                throw std::runtime_error("snapshot bucket table truncated");
+            }
+
+            for (size_t i = 0; i < table.size(); i++) {
+                const SnapshotBucket& entry = table[i];
+                if (entry.offset_ == 0) continue;
+
+                size_t capacity_bytes = bucket_capacity(i) * sizeof(T);
+                if (entry.bytes_ > capacity_bytes || entry.offset_ % header.alignment_ != 0
+                    || entry.offset_ + entry.bytes_ > static_cast<uint64_t>(st.st_size)) {
+                    throw std::runtime_error("snapshot bucket out of range");
+                }
+
+                // reserve the whole bucket as zeroed anonymous memory, then lay the stored part over it
+                size_t length = (capacity_bytes + header.alignment_ - 1) / header.alignment_ * header.alignment_;
+                void* region = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (region == MAP_FAILED) throw_snapshot_errno("mmap");
+                buckets[i] = static_cast<T*>(region);
+                mapped[i] = length;
+
+                if (entry.bytes_ > 0) {
+                    size_t file_length = (entry.bytes_ + header.alignment_ - 1) / header.alignment_ * header.alignment_;
+                    void* data = ::mmap(region, file_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+                                        static_cast<off_t>(entry.offset_));
+                    if (data == MAP_FAILED) throw_snapshot_errno("mmap");
+                    if (verify && snapshot_checksum(data, entry.bytes_) != entry.checksum_) {
+                        throw std::runtime_error("snapshot bucket checksum mismatch");
+                    }
+                }
+            }
+        } catch (...) {
+            for (size_t i = 0; i < MAX_BUCKETS; i++) {
+                if (buckets[i]) ::munmap(buckets[i], mapped[i]);
+                buckets[i] = nullptr;
+            }
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        return header;
+    }
+
+    void install_bucket(size_t bucket, T* memory, size_t mapped_bytes) {
+        if (T* old = memory_[bucket].load()) {
+            release_bucket(bucket, old);
+        }
+        delete frozen_[bucket].exchange(nullptr);
+        spilled_[bucket].store(0);
+        memory_[bucket].store(memory);
+        mapped_bytes_[bucket] = mapped_bytes;
+        dirty_[bucket].store(false);
+    }
+
+    void finish_restore(const SnapshotHeader& header) {
+        uint32_t ops = descriptor_.load()->counter_ - chain_start_counter_;
+        abandoned_descriptors_ += 1 + ops;
+        abandoned_write_descriptors_ += ops;
+        chain_start_counter_ = header.counter_;
+        descriptor_.store(new_descriptor<Descriptor>(header.size_, header.counter_));
+        storage_.publish(header.size_, header.counter_);
+    }
+};
+
+#endif  // LOCK_FREE_VECTOR_CPP
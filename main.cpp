@@ -1,4 +1,6 @@
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <algorithm>
 #include <numeric>
@@ -6,7 +8,27 @@
 #include <iomanip>
 #include <thread>
 #include <random>
+#include <mutex>
+#include <shared_mutex>
+#include <queue>
+#include <filesystem>
 #include "lock-free-vector.cpp"
+#include "lock-free-queue.cpp"
+#include "durable-log.cpp"
+#include "persistent-vector.cpp"
+#include "shared-vector.cpp"
+#include "columnar-vector.cpp"
+#include "op-trace.cpp"
+#include "perf-counters.cpp"
+#include "alloc-tracking.cpp"
+#include "bench-harness.cpp"
+#include <fstream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#ifdef LFV_HAVE_TBB
+#include <tbb/concurrent_vector.h>
+#endif
 
 using namespace std::chrono;
 struct BenchmarkStats {
@@ -18,6 +40,11 @@ struct BenchmarkStats {
     std::vector<double> raw_times;
     double percentile_99 = 0.0;
     double percentile_95 = 0.0;
+    long peak_rss_kb = 0;
+    long peak_rss_growth_kb = 0;   // peak minus RSS when the runs started, leaks from earlier runs excluded
+    PerfCounters::Sample perf;     // summed over all runs, only with LFV_PERF set
+    AllocationCounts allocations;  // during the timed region, summed over all runs
+    uint64_t operations = 0;       // over all runs, the denominator for perf and allocations
 
     void calculate(std::vector<double>& times) {
         if (times.empty()) return;
@@ -47,6 +74,40 @@ struct BenchmarkStats {
     }
 };
 
+long read_status_kb(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t length = std::strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, field) == 0) return std::stol(line.substr(length));
+    }
+    return 0;
+}
+
+// VmHWM is the process's peak RSS; writing 5 to clear_refs resets it to the current RSS (linux 4.0+),
+// so every configuration gets its own peak. returns the RSS the peak starts from
+long reset_peak_rss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+    return read_status_kb("VmRSS:");
+}
+
+long read_peak_rss_kb() {
+    return read_status_kb("VmHWM:");
+}
+
+// hardware counters are opt-in with LFV_PERF=1, null when not requested or not permitted
+std::unique_ptr<PerfCounters> make_perf_counters() {
+    if (!std::getenv("LFV_PERF")) return nullptr;
+    auto perf = std::make_unique<PerfCounters>();
+    if (perf->available()) return perf;
+    static bool warned = false;
+    if (!warned) {
+        std::cerr << "perf counters unavailable: " << perf->error() << " (no PMU, or perf_event_paranoid too strict)\n";
+        warned = true;
+    }
+    return nullptr;
+}
+
 template<typename T>
 class VectorWrapper {
 public:
@@ -59,9 +120,30 @@ public:
 };
 
 template<typename T>
-class LockFreeVectorWrapper : public VectorWrapper<T> {
-    LockFreeVector<T> vec;
+class LockFreeVectorWrapper final : public VectorWrapper<T> {
+    mutable LockFreeVector<T> vec;
+public:
+    void push_back(const T& value) override { vec.push_back(value); }
+    T pop_back() override { return vec.pop_back(); }
+    void write(size_t index, const T& value) override { vec.write(index, value); }
+    T read(size_t index) const override { return vec.read(index); }
+    size_t size() const override { return vec.size(); }
+};
+
+// every instance gets its own segment, used from threads of this process only
+template<typename T>
+class SharedLockFreeVectorWrapper final : public VectorWrapper<T> {
+    static std::string next_name() {
+        static std::atomic<int> instance{0};
+        return "/lfv_bench_" + std::to_string(::getpid()) + "_" + std::to_string(instance++);
+    }
+
+    std::string name;
+    mutable SharedLockFreeVector<T> vec;
 public:
+    SharedLockFreeVectorWrapper() : name(next_name()), vec(name, 1 << 22) {}
+    ~SharedLockFreeVectorWrapper() override { SharedLockFreeVector<T>::remove(name); }
+
     void push_back(const T& value) override { vec.push_back(value); }
     T pop_back() override { return vec.pop_back(); }
     void write(size_t index, const T& value) override { vec.write(index, value); }
@@ -70,7 +152,7 @@ public:
 };
 
 template<typename T>
-class MutexVectorWrapper : public VectorWrapper<T> {
+class MutexVectorWrapper final : public VectorWrapper<T> {
     std::vector<T> vec;
     mutable std::mutex mutex;
 public:
@@ -105,7 +187,365 @@ public:
     }
 };
 
+// test-and-test-and-set lock, waiters spin on a shared load instead of hammering the line with exchanges
+template<typename T>
+class SpinlockVectorWrapper final : public VectorWrapper<T> {
+    std::vector<T> vec;
+    mutable std::atomic<bool> locked{false};
+
+    void lock() const {
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            while (locked.load(std::memory_order_relaxed)) {
+#if defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#else
+                std::this_thread::yield();
+#endif
+            }
+        }
+    }
+    void unlock() const { locked.store(false, std::memory_order_release); }
+
+public:
+    void push_back(const T& value) override {
+        lock();
+        vec.push_back(value);
+        unlock();
+    }
+
+    T pop_back() override {
+        lock();
+        if (vec.empty()) {
+            unlock();
+            throw std::out_of_range("empty");
+        }
+        T value = vec.back();
+        vec.pop_back();
+        unlock();
+        return value;
+    }
+
+    void write(size_t index, const T& value) override {
+        lock();
+        bool in_range = index < vec.size();
+        if (in_range) vec[index] = value;
+        unlock();
+        if (!in_range) throw std::out_of_range("index");
+    }
+
+    T read(size_t index) const override {
+        lock();
+        if (index >= vec.size()) {
+            unlock();
+            throw std::out_of_range("index");
+        }
+        T value = vec[index];
+        unlock();
+        return value;
+    }
+
+    size_t size() const override {
+        lock();
+        size_t size = vec.size();
+        unlock();
+        return size;
+    }
+};
+
+// reads and size share the lock, everything that changes the vector takes it exclusively
+template<typename T>
+class SharedMutexVectorWrapper final : public VectorWrapper<T> {
+    std::vector<T> vec;
+    mutable std::shared_mutex mutex;
+public:
+    void push_back(const T& value) override {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        vec.push_back(value);
+    }
+
+    T pop_back() override {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (vec.empty()) throw std::out_of_range("empty");
+        T value = vec.back();
+        vec.pop_back();
+        return value;
+    }
+
+    void write(size_t index, const T& value) override {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (index >= vec.size()) throw std::out_of_range("index");
+        vec[index] = value;
+    }
+
+    T read(size_t index) const override {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (index >= vec.size()) throw std::out_of_range("index");
+        return vec[index];
+    }
+
+    size_t size() const override {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return vec.size();
+    }
+};
+
+// fixed-size segments with a lock each, elements never move. reads and writes only lock their
+// segment, push_back and pop_back serialize on the tail lock and then lock the tail segment
+template<typename T>
+class SegmentedVectorWrapper final : public VectorWrapper<T> {
+    static constexpr size_t SEGMENT_SIZE = 1024;
+    static constexpr size_t MAX_SEGMENTS = 1 << 16;
+
+    struct Segment {
+        mutable std::mutex mutex;
+        T data[SEGMENT_SIZE];
+    };
+
+    std::unique_ptr<std::atomic<Segment*>[]> segments{new std::atomic<Segment*>[MAX_SEGMENTS]()};
+    std::atomic<size_t> count{0};
+    std::mutex tail_mutex;
+
+public:
+    ~SegmentedVectorWrapper() override {
+        for (size_t i = 0; i < MAX_SEGMENTS; ++i) delete segments[i].load();
+    }
+
+    void push_back(const T& value) override {
+        std::lock_guard<std::mutex> tail(tail_mutex);
+        size_t i = count.load(std::memory_order_relaxed);
+        if (i / SEGMENT_SIZE >= MAX_SEGMENTS) throw std::length_error("segmented vector full");
+        Segment* segment = segments[i / SEGMENT_SIZE].load(std::memory_order_relaxed);
+        if (!segment) {
+            segment = new Segment();
+            segments[i / SEGMENT_SIZE].store(segment, std::memory_order_release);
+        }
+        {
+            std::lock_guard<std::mutex> lock(segment->mutex);
+            segment->data[i % SEGMENT_SIZE] = value;
+        }
+        count.store(i + 1, std::memory_order_release);
+    }
+
+    T pop_back() override {
+        std::lock_guard<std::mutex> tail(tail_mutex);
+        size_t i = count.load(std::memory_order_relaxed);
+        if (i == 0) throw std::out_of_range("empty");
+        --i;
+        count.store(i, std::memory_order_release);
+        Segment* segment = segments[i / SEGMENT_SIZE].load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(segment->mutex);
+        return segment->data[i % SEGMENT_SIZE];
+    }
+
+    void write(size_t index, const T& value) override {
+        if (index >= count.load(std::memory_order_acquire)) throw std::out_of_range("index");
+        Segment* segment = segments[index / SEGMENT_SIZE].load(std::memory_order_acquire);
+        std::lock_guard<std::mutex> lock(segment->mutex);
+        segment->data[index % SEGMENT_SIZE] = value;
+    }
+
+    T read(size_t index) const override {
+        if (index >= count.load(std::memory_order_acquire)) throw std::out_of_range("index");
+        Segment* segment = segments[index / SEGMENT_SIZE].load(std::memory_order_acquire);
+        std::lock_guard<std::mutex> lock(segment->mutex);
+        return segment->data[index % SEGMENT_SIZE];
+    }
+
+    size_t size() const override { return count.load(std::memory_order_acquire); }
+};
+
+// read-copy-update on growth: readers never lock, they load the current array and read it.
+// every modification serializes on one mutex, a full array is copied into one twice the size and
+// published, replaced arrays are retired until destruction instead of after a grace period.
+// a reader holding a replaced array can miss a write made after the copy
+template<typename T>
+class RcuVectorWrapper final : public VectorWrapper<T> {
+    struct Array {
+        size_t capacity;
+        std::unique_ptr<std::atomic<T>[]> data;
+        explicit Array(size_t capacity) : capacity(capacity), data(new std::atomic<T>[capacity]()) {}
+    };
+
+    std::atomic<Array*> current;
+    std::atomic<size_t> count{0};
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Array>> arrays;   // current and every retired one
+
+public:
+    RcuVectorWrapper() {
+        arrays.push_back(std::make_unique<Array>(1024));
+        current.store(arrays.back().get());
+    }
+
+    void push_back(const T& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        Array* array = current.load(std::memory_order_relaxed);
+        size_t i = count.load(std::memory_order_relaxed);
+        if (i == array->capacity) {
+            auto grown = std::make_unique<Array>(array->capacity * 2);
+            for (size_t j = 0; j < i; ++j) {
+                grown->data[j].store(array->data[j].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            array = grown.get();
+            arrays.push_back(std::move(grown));
+            current.store(array, std::memory_order_release);
+        }
+        array->data[i].store(value, std::memory_order_relaxed);
+        // readers load count before current, so an index below count is always in the array they see
+        count.store(i + 1, std::memory_order_release);
+    }
+
+    T pop_back() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t i = count.load(std::memory_order_relaxed);
+        if (i == 0) throw std::out_of_range("empty");
+        count.store(i - 1, std::memory_order_release);
+        return current.load(std::memory_order_relaxed)->data[i - 1].load(std::memory_order_relaxed);
+    }
+
+    void write(size_t index, const T& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index >= count.load(std::memory_order_relaxed)) throw std::out_of_range("index");
+        current.load(std::memory_order_relaxed)->data[index].store(value, std::memory_order_relaxed);
+    }
+
+    T read(size_t index) const override {
+        if (index >= count.load(std::memory_order_acquire)) throw std::out_of_range("index");
+        return current.load(std::memory_order_acquire)->data[index].load(std::memory_order_relaxed);
+    }
+
+    size_t size() const override { return count.load(std::memory_order_acquire); }
+};
+
+#ifdef LFV_HAVE_TBB
+// tbb::concurrent_vector grows without moving elements but cannot shrink concurrently, pop_back
+// always throws out_of_range like an empty vector, so the mix only pushes, reads and writes.
+// its size() counts slots whose construction may still be running, reading one is a data race,
+// so reads and size() go by published, which pushers advance in index order once constructed
+template<typename T>
+class TbbVectorWrapper final : public VectorWrapper<T> {
+    tbb::concurrent_vector<std::atomic<T>> vec;
+    std::atomic<size_t> published{0};
+public:
+    void push_back(const T& value) override {
+        size_t index = static_cast<size_t>(vec.emplace_back(value) - vec.begin());
+        // waits for pushers of lower indices, so a descheduled pusher holds up the ones after it
+        for (size_t expected = index;
+             !published.compare_exchange_weak(expected, index + 1, std::memory_order_release, std::memory_order_relaxed);
+             expected = index) {
+            std::this_thread::yield();
+        }
+    }
+
+    T pop_back() override { throw std::out_of_range("concurrent_vector has no concurrent pop_back"); }
+
+    void write(size_t index, const T& value) override {
+        if (index >= published.load(std::memory_order_acquire)) throw std::out_of_range("index");
+        vec[index].store(value, std::memory_order_relaxed);
+    }
+
+    T read(size_t index) const override {
+        if (index >= published.load(std::memory_order_acquire)) throw std::out_of_range("index");
+        return vec[index].load(std::memory_order_relaxed);
+    }
+
+    size_t size() const override { return published.load(std::memory_order_acquire); }
+};
+#endif
+
+template<typename T>
+class QueueWrapper {
+public:
+    virtual void enqueue(const T& value) = 0;
+    virtual bool try_dequeue(T& out) = 0;
+    virtual ~QueueWrapper() = default;
+};
+
+template<typename T>
+class LockFreeQueueWrapper : public QueueWrapper<T> {
+    LockFreeQueue<T> queue;
+public:
+    void enqueue(const T& value) override { queue.enqueue(value); }
+    bool try_dequeue(T& out) override { return queue.try_dequeue(out); }
+};
+
+template<typename T>
+class MutexQueueWrapper : public QueueWrapper<T> {
+    std::queue<T> queue;
+    std::mutex mutex;
+public:
+    void enqueue(const T& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push(value);
+    }
+
+    bool try_dequeue(T& out) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) return false;
+        out = queue.front();
+        queue.pop();
+        return true;
+    }
+};
+
+// fifo emulated with push_back plus a shared head index, consumed slots are never reclaimed
+template<typename T>
+class VectorHeadQueueWrapper : public QueueWrapper<T> {
+    LockFreeVector<T> vec;
+    std::atomic<size_t> head{0};
+public:
+    void enqueue(const T& value) override { vec.push_back(value); }
+
+    // completed_size(): a slot below plain size() may still be waiting for its pusher's value
+    bool try_dequeue(T& out) override {
+        size_t h = head.load();
+        while (h < vec.completed_size()) {
+            if (head.compare_exchange_weak(h, h + 1)) {
+                out = vec.read(h);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// every result print_stats() shows, written by write_results_json() for lfv_compare. names are
+// the title plus result_context, so the same title at different thread counts stays apart
+struct RecordedResult {
+    std::string name;
+    BenchmarkStats stats;
+};
+std::vector<RecordedResult> recorded_results;
+std::string result_context;
+
+void record_result(const std::string& title, const BenchmarkStats& stats) {
+    std::string name = result_context.empty() ? title : title + " [" + result_context + "]";
+    int seen = 0;
+    for (const RecordedResult& result : recorded_results) {
+        if (result.name == name || result.name.rfind(name + " #", 0) == 0) seen++;
+    }
+    if (seen > 0) name += " #" + std::to_string(seen + 1);
+    recorded_results.push_back({name, stats});
+}
+
+void write_results_json(const std::string& path) {
+    std::ofstream out(path);
+    out << "{\"unit\": \"us\", \"results\": [";
+    for (size_t i = 0; i < recorded_results.size(); ++i) {
+        const RecordedResult& result = recorded_results[i];
+        out << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << result.name << "\", \"median\": " << result.stats.median
+            << ", \"mean\": " << result.stats.mean << ", \"raw_times\": [";
+        for (size_t j = 0; j < result.stats.raw_times.size(); ++j) {
+            out << (j ? ", " : "") << result.stats.raw_times[j];
+        }
+        out << "]}";
+    }
+    out << "\n]}\n";
+    if (!out) throw std::runtime_error("cannot write " + path);
+}
+
 void print_stats(const std::string& title, const BenchmarkStats& stats) {
+    record_result(title, stats);
     std::cout << "\n=== " << title << " ===\n";
     std::cout << std::fixed << std::setprecision(3)
               << "Mean:       " << stats.mean << " µs\n"
@@ -114,7 +554,32 @@ void print_stats(const std::string& title, const BenchmarkStats& stats) {
               << "Min:        " << stats.min << " µs\n"
               << "Max:        " << stats.max << " µs\n"
               << "99th %ile:  " << stats.percentile_99 << " µs\n"
-              << "95th %ile:  " << stats.percentile_95 << " µs\n\n";
+              << "95th %ile:  " << stats.percentile_95 << " µs\n";
+    if (stats.peak_rss_kb > 0) {
+        std::cout << "Peak RSS:   " << stats.peak_rss_kb << " KiB (+" << stats.peak_rss_growth_kb << " KiB during runs)\n";
+    }
+    if (stats.operations > 0) {
+        double ops = static_cast<double>(stats.operations);
+        std::cout << "Allocs/op:  " << std::setprecision(3) << static_cast<double>(stats.allocations.allocations_) / ops
+                  << " (" << static_cast<double>(stats.allocations.bytes_) / ops << " bytes/op)\n";
+    }
+    if (stats.operations > 0 && stats.perf.valid_[PerfCounters::CYCLES]) {
+        const PerfCounters::Sample& perf = stats.perf;
+        auto per_op = [&](PerfCounters::Event event) {
+            return static_cast<double>(perf.counts_[event]) / static_cast<double>(stats.operations);
+        };
+        std::cout << "IPC:        " << std::setprecision(2) << perf.ipc()
+                  << " (" << per_op(PerfCounters::CYCLES) << " cycles/op)\n"
+                  << "Misses/op:  ";
+        const std::pair<PerfCounters::Event, const char*> misses[] = {
+            {PerfCounters::L1D_MISSES, "L1D"}, {PerfCounters::LLC_MISSES, "LLC"},
+            {PerfCounters::DTLB_MISSES, "dTLB"}, {PerfCounters::HITM, "HITM"}};
+        for (const auto& [event, name] : misses) {
+            if (perf.valid_[event]) std::cout << name << " " << std::setprecision(3) << per_op(event) << "  ";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "\n";
 }
 
 template<typename VectorType>
@@ -137,6 +602,9 @@ BenchmarkStats run_mixed_ops_benchmark(int num_threads, int num_runs) {
         for (auto& t : threads) t.join();
     }
 
+    std::unique_ptr<PerfCounters> perf = make_perf_counters();
+    AllocationCounts allocations;
+    long start_rss_kb = reset_peak_rss();
     for (int run = 0; run < num_runs; ++run) {
         std::unique_ptr<VectorWrapper<int>> vec = std::make_unique<VectorType>();
 
@@ -145,6 +613,8 @@ BenchmarkStats run_mixed_ops_benchmark(int num_threads, int num_runs) {
         }
 
         std::vector<std::thread> threads;
+        AllocationCounts allocations_before = AllocationTracker::totals();
+        if (perf) perf->start();
         auto start_time = high_resolution_clock::now();
 
         for (int i = 0; i < num_threads; ++i) {
@@ -187,6 +657,8 @@ BenchmarkStats run_mixed_ops_benchmark(int num_threads, int num_runs) {
         }
 
         auto end_time = high_resolution_clock::now();
+        if (perf) perf->stop();
+        allocations += AllocationTracker::totals() - allocations_before;
         auto duration = duration_cast<microseconds>(end_time - start_time).count();
         times.push_back(static_cast<double>(duration));
 
@@ -195,11 +667,681 @@ BenchmarkStats run_mixed_ops_benchmark(int num_threads, int num_runs) {
 
     BenchmarkStats stats;
     stats.calculate(times);
+    stats.peak_rss_kb = read_peak_rss_kb();
+    stats.peak_rss_growth_kb = stats.peak_rss_kb - start_rss_kb;
+    if (perf) stats.perf = perf->read();
+    stats.allocations = allocations;
+    stats.operations = static_cast<uint64_t>(num_threads) * 100000 * num_runs;
     return stats;
 }
 
+// half the threads produce, half consume, until every produced item has been dequeued
+template<typename QueueType>
+BenchmarkStats run_queue_benchmark(int num_threads, int num_runs) {
+    const int items_per_producer = 100000;
+    int producers = std::max(1, num_threads / 2);
+    int consumers = std::max(1, num_threads - producers);
+    std::vector<double> times;
+    times.reserve(num_runs);
+    std::unique_ptr<PerfCounters> perf = make_perf_counters();
+    AllocationCounts allocations;
+
+    for (int run = 0; run < num_runs; ++run) {
+        std::unique_ptr<QueueWrapper<int>> queue = std::make_unique<QueueType>();
+        std::atomic<int> remaining(producers * items_per_producer);
+        std::vector<std::thread> threads;
+        AllocationCounts allocations_before = AllocationTracker::totals();
+        if (perf) perf->start();
+        auto start_time = high_resolution_clock::now();
+
+        for (int i = 0; i < producers; ++i) {
+            threads.emplace_back([&queue]() {
+                for (int j = 0; j < items_per_producer; ++j) {
+                    queue->enqueue(j);
+                }
+            });
+        }
+        for (int i = 0; i < consumers; ++i) {
+            threads.emplace_back([&queue, &remaining]() {
+                int value;
+                while (remaining.load(std::memory_order_relaxed) > 0) {
+                    if (queue->try_dequeue(value)) {
+                        remaining.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        auto end_time = high_resolution_clock::now();
+        if (perf) perf->stop();
+        allocations += AllocationTracker::totals() - allocations_before;
+        times.push_back(static_cast<double>(duration_cast<microseconds>(end_time - start_time).count()));
+    }
+
+    BenchmarkStats stats;
+    stats.calculate(times);
+    if (perf) stats.perf = perf->read();
+    stats.allocations = allocations;
+    // an enqueue and a dequeue per item, failed dequeue polls are not counted
+    stats.operations = 2ULL * producers * items_per_producer * num_runs;
+    std::cout << std::fixed << std::setprecision(0) << "Throughput: "
+              << 2.0 * producers * items_per_producer / (stats.median / 1e6) << " ops/s (median run)";
+    return stats;
+}
+
+// every thread appends without waiting and makes its last append durable every sync_every records,
+// so up to num_threads * sync_every records are staged when a leader flushes and max_batch decides
+// how they are split. synchronous push_back would cap batches at num_threads
+BenchmarkStats run_durable_append_benchmark(int num_threads, size_t max_batch, int num_runs) {
+    const int appends_per_thread = 1024;
+    const int sync_every = 128;
+    std::vector<double> times;
+    times.reserve(num_runs);
+    std::string path = (std::filesystem::temp_directory_path() / "lock_free_vector_bench.wal").string();
+    size_t records = 0;
+    size_t flushes = 0;
+
+    for (int run = 0; run < num_runs; ++run) {
+        std::filesystem::remove(path);
+        DurableLog<int> log(path, max_batch);
+        std::vector<std::thread> threads;
+        auto start_time = high_resolution_clock::now();
+
+        for (int i = 0; i < num_threads; ++i) {
+            threads.emplace_back([&log]() {
+                for (int j = 0; j < appends_per_thread; ++j) {
+                    size_t index = log.append(j);
+                    if ((j + 1) % sync_every == 0 || j + 1 == appends_per_thread) {
+                        log.wait_durable(index);
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        auto end_time = high_resolution_clock::now();
+        times.push_back(static_cast<double>(duration_cast<microseconds>(end_time - start_time).count()));
+        records += log.durable_size();
+        flushes += log.flushes();
+    }
+    std::filesystem::remove(path);
+
+    BenchmarkStats stats;
+    stats.calculate(times);
+    std::cout << std::fixed << std::setprecision(0) << "Durable appends: "
+              << num_threads * appends_per_thread / (stats.median / 1e6) << " /s (median run), mean batch "
+              << std::setprecision(1) << static_cast<double>(records) / std::max<size_t>(flushes, 1);
+    return stats;
+}
+
+// reopening a mapped file vs rebuilding a heap vector from a flat dump of the same elements
+void run_cold_start_benchmark(size_t num_elements, int num_runs) {
+    auto dir = std::filesystem::temp_directory_path();
+    std::string mapped_path = (dir / "lock_free_vector_bench.lfv").string();
+    std::string dump_path = (dir / "lock_free_vector_bench.dump").string();
+    std::filesystem::remove(mapped_path);
+
+    {
+        PersistentLockFreeVector<int> vec{MappedFileStorage<int>(mapped_path)};
+        std::vector<int> flat;
+        flat.reserve(num_elements);
+        for (size_t i = 0; i < num_elements; ++i) {
+            vec.push_back(static_cast<int>(i));
+            flat.push_back(static_cast<int>(i));
+        }
+        std::ofstream out(dump_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(flat.data()), flat.size() * sizeof(int));
+    }
+
+    std::vector<double> mapped_times, reload_times;
+    for (int run = 0; run < num_runs; ++run) {
+        auto start_time = high_resolution_clock::now();
+        {
+            PersistentLockFreeVector<int> vec{MappedFileStorage<int>(mapped_path)};
+            volatile int last = vec.read(vec.size() - 1);
+            (void)last;
+            mapped_times.push_back(static_cast<double>(
+                duration_cast<microseconds>(high_resolution_clock::now() - start_time).count()));
+        }
+
+        start_time = high_resolution_clock::now();
+        {
+            LockFreeVector<int> vec;
+            std::ifstream in(dump_path, std::ios::binary);
+            std::vector<int> chunk(1 << 16);
+            while (in.read(reinterpret_cast<char*>(chunk.data()), chunk.size() * sizeof(int)) || in.gcount() > 0) {
+                size_t n = static_cast<size_t>(in.gcount()) / sizeof(int);
+                for (size_t i = 0; i < n; ++i) {
+                    vec.push_back(chunk[i]);
+                }
+            }
+            volatile int last = vec.read(vec.size() - 1);
+            (void)last;
+            reload_times.push_back(static_cast<double>(
+                duration_cast<microseconds>(high_resolution_clock::now() - start_time).count()));
+        }
+    }
+
+    std::filesystem::remove(mapped_path);
+    std::filesystem::remove(dump_path);
+
+    BenchmarkStats mapped_stats, reload_stats;
+    mapped_stats.calculate(mapped_times);
+    reload_stats.calculate(reload_times);
+    print_stats("Cold Start: Reopen Mapped File", mapped_stats);
+    print_stats("Cold Start: Reload Serialized Dump", reload_stats);
+}
+
+void run_snapshot_benchmark(size_t num_elements, int num_runs) {
+    std::string path = (std::filesystem::temp_directory_path() / "lock_free_vector_bench.lfvs").string();
+    LockFreeVector<int64_t> source;
+    for (size_t i = 0; i < num_elements; ++i) {
+        source.push_back(static_cast<int64_t>(i));
+    }
+
+    std::vector<double> save_times, load_times, load_unverified_times;
+    for (int run = 0; run < num_runs; ++run) {
+        auto start_time = high_resolution_clock::now();
+        source.save(path);
+        save_times.push_back(static_cast<double>(
+            duration_cast<microseconds>(high_resolution_clock::now() - start_time).count()));
+
+        for (bool verify : {true, false}) {
+            LockFreeVector<int64_t> restored;
+            start_time = high_resolution_clock::now();
+            restored.load(path, verify);
+            (verify ? load_times : load_unverified_times).push_back(static_cast<double>(
+                duration_cast<microseconds>(high_resolution_clock::now() - start_time).count()));
+        }
+    }
+    std::filesystem::remove(path);
+
+    double gigabytes = num_elements * sizeof(int64_t) / 1e9;
+    BenchmarkStats save_stats, load_stats, load_unverified_stats;
+    save_stats.calculate(save_times);
+    load_stats.calculate(load_times);
+    load_unverified_stats.calculate(load_unverified_times);
+    std::cout << std::fixed << std::setprecision(2)
+              << "save:                   " << gigabytes / (save_stats.median / 1e6) << " GB/s\n"
+              << "load (checksummed):     " << gigabytes / (load_stats.median / 1e6) << " GB/s\n"
+              << "load (no verification): " << gigabytes / (load_unverified_stats.median / 1e6) << " GB/s\n";
+    print_stats("Snapshot Save", save_stats);
+    print_stats("Snapshot Load", load_stats);
+}
+
+// delta checkpoint cost for writes confined to the first `hot_range` elements
+void run_checkpoint_benchmark(size_t num_elements, int num_runs) {
+    std::string manifest = (std::filesystem::temp_directory_path() / "lock_free_vector_bench.manifest").string();
+    LockFreeVector<int64_t> vec;
+    for (size_t i = 0; i < num_elements; ++i) {
+        vec.push_back(static_cast<int64_t>(i));
+    }
+
+    std::mt19937 gen(42);
+    for (size_t hot_range : {size_t(0), size_t(1000), num_elements / 16, num_elements}) {
+        std::vector<double> times;
+        for (int run = 0; run < num_runs; ++run) {
+            vec.checkpoint(manifest, true);
+            if (hot_range > 0) {
+                std::uniform_int_distribution<size_t> index_dist(0, hot_range - 1);
+                for (int w = 0; w < 1000; ++w) {
+                    vec.write(index_dist(gen), w);
+                }
+            }
+
+            auto start_time = high_resolution_clock::now();
+            vec.checkpoint(manifest);
+            times.push_back(static_cast<double>(
+                duration_cast<microseconds>(high_resolution_clock::now() - start_time).count()));
+        }
+
+        BenchmarkStats stats;
+        stats.calculate(times);
+        print_stats("Delta Checkpoint, 1000 writes over first " + std::to_string(hot_range) + " elements", stats);
+    }
+
+    // chain files are numbered on across checkpoints, the manifest names the live ones
+    std::ifstream chain(manifest);
+    for (std::string file; std::getline(chain, file); ) {
+        if (!file.empty()) std::filesystem::remove(file);
+    }
+    std::filesystem::remove(manifest);
+}
+
+// monotonic timestamps with jitter: memory per element and random-read latency before/after freezing.
+// num_buckets full buckets are filled so the comparison is not skewed by a half-empty last bucket
+void run_frozen_bucket_benchmark(size_t num_buckets) {
+    const int num_reads = 1 << 22;
+    size_t num_elements = (8UL << num_buckets) - 8;
+    LockFreeVector<int64_t> vec;
+    int64_t timestamp = 1700000000000000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int64_t> jitter(0, 999);
+    for (size_t i = 0; i < num_elements; ++i) {
+        timestamp += 1000 + jitter(gen);
+        vec.push_back(timestamp);
+    }
+
+    std::vector<size_t> indices(num_reads);
+    std::uniform_int_distribution<size_t> index_dist(0, num_elements - 1);
+    for (auto& index : indices) index = index_dist(gen);
+
+    auto random_read_ns = [&]() {
+        int64_t sum = 0;
+        auto start_time = high_resolution_clock::now();
+        for (size_t index : indices) {
+            sum += vec.read(index);
+        }
+        auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count();
+        volatile int64_t sink = sum;
+        (void)sink;
+        return static_cast<double>(elapsed) / num_reads;
+    };
+
+    double raw_ns = random_read_ns();
+    size_t frozen_count = vec.freeze_cold_buckets(0);
+    vec.collect_retired();
+    double frozen_ns = random_read_ns();
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "raw:    " << static_cast<double>(sizeof(int64_t)) << " bytes/element, "
+              << raw_ns << " ns/random read\n"
+              << "frozen: " << static_cast<double>(vec.frozen_bytes()) / num_elements << " bytes/element ("
+              << frozen_count << " buckets), " << frozen_ns << " ns/random read\n";
+}
+
+// reads in rounds with the budget enforced between rounds, 90% of reads land in the newest quarter
+// of the data so the clock sweep has a hot set to keep
+void run_tiered_storage_benchmark(size_t num_buckets, int num_rounds) {
+    const int reads_per_round = 1 << 20;
+    size_t num_elements = (8UL << num_buckets) - 8;
+    size_t data_bytes = (num_elements + 8) * sizeof(int64_t);
+
+    for (double fraction : {1.0, 0.75, 0.5, 0.25}) {
+        LockFreeVector<int64_t> vec;
+        vec.enable_tiering("/tmp/lfv_bench_tier", static_cast<size_t>(data_bytes * fraction));
+        for (size_t i = 0; i < num_elements; ++i) {
+            vec.push_back(static_cast<int64_t>(i));
+        }
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<size_t> any(0, num_elements - 1);
+        std::uniform_int_distribution<size_t> hot(num_elements - num_elements / 4, num_elements - 1);
+        std::bernoulli_distribution pick_hot(0.9);
+        std::vector<size_t> indices(reads_per_round);
+
+        size_t evicted = 0;
+        int64_t sum = 0;
+        long long elapsed = 0;
+        for (int round = 0; round < num_rounds; ++round) {
+            for (auto& index : indices) index = pick_hot(gen) ? hot(gen) : any(gen);
+
+            auto start_time = high_resolution_clock::now();
+            for (size_t index : indices) {
+                sum += vec.read(index);
+            }
+            evicted += vec.enforce_memory_budget();
+            vec.collect_retired();
+            elapsed += duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count();
+        }
+        volatile int64_t sink = sum;
+        (void)sink;
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "budget " << std::setw(3) << static_cast<int>(fraction * 100) << "%: "
+                  << static_cast<double>(reads_per_round) * num_rounds * 1000.0 / elapsed << " M reads/s, "
+                  << evicted << " evictions, " << vec.resident_bytes() / (1024 * 1024) << " MiB resident\n";
+    }
+}
+
+// push/pop storm on one vector, then the contention counters it accumulated
+void run_contention_stats_report(int num_threads, int ops_per_thread) {
+    LockFreeVector<int> vec;
+    // watch it live with lfv_monitor <pid>
+    vec.export_live_stats("contention_report_" + std::to_string(num_threads));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&vec, ops_per_thread]() {
+            for (int i = 0; i < ops_per_thread; ++i) {
+                vec.push_back(i);
+                if (i % 4 == 3) vec.pop_back();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    VectorStats stats = vec.stats();
+    if (stats.operations_ == 0) {
+        std::cout << "counters disabled, build with -DLFV_STATS\n";
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(3)
+              << "operations:            " << stats.operations_ << "\n"
+              << "retries/op:            " << static_cast<double>(stats.retries_) / stats.operations_
+              << " (max " << stats.max_retries_ << ")\n"
+              << "descriptor CAS:        " << stats.descriptor_cas_attempts_ << " attempts, "
+              << stats.descriptor_cas_failures_ << " failed\n"
+              << "helped writes:         " << stats.helped_writes_ << "\n"
+              << "bucket allocations:    " << stats.bucket_allocations_ << " ("
+              << stats.bucket_allocation_races_ << " lost races)\n"
+              << "descriptor allocations: " << stats.descriptor_allocations_ << "\n";
+}
+
+// mixed push/read/write/pop load, then the tail latency the vector recorded for each operation
+void run_latency_report(int num_threads, int ops_per_thread) {
+    LockFreeVector<int> vec;
+    for (int i = 0; i < 1000; ++i) vec.push_back(i);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&vec, ops_per_thread, t]() {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> index_dist(0, 999);
+            for (int i = 0; i < ops_per_thread; ++i) {
+                vec.push_back(i);
+                vec.read(index_dist(gen));
+                vec.write(index_dist(gen), i);
+                vec.pop_back();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    const std::pair<VectorOp, const char*> ops[] = {
+        {VectorOp::PUSH_BACK, "push_back"}, {VectorOp::POP_BACK, "pop_back"},
+        {VectorOp::READ, "read"}, {VectorOp::WRITE, "write"}};
+    for (const auto& [op, name] : ops) {
+        LatencyHistogram histogram;
+        vec.latency(op, histogram);
+        if (histogram.count() == 0) {
+            std::cout << "histograms disabled, build with -DLFV_LATENCY\n";
+            return;
+        }
+        std::cout << std::left << std::setw(10) << name << std::right
+                  << " p50 " << std::setw(6) << histogram.percentile(50)
+                  << " p99 " << std::setw(6) << histogram.percentile(99)
+                  << " p99.9 " << std::setw(7) << histogram.percentile(99.9)
+                  << " p99.99 " << std::setw(8) << histogram.percentile(99.99)
+                  << " max " << histogram.max() << " ns\n";
+    }
+}
+
+// where a vector's memory sits after the mixed workload of run_mixed_ops_benchmark
+void run_memory_accounting_report(int num_threads) {
+    LockFreeVector<int> vec;
+    for (int i = 0; i < 10000; ++i) vec.push_back(i);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&vec, t]() {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<> op_dist(0, 99);
+            for (int op = 0; op < 100000; ++op) {
+                int operation = op_dist(gen);
+                try {
+                    if (operation < 15) {
+                        vec.push_back(op);
+                    } else if (operation < 20) {
+                        vec.pop_back();
+                    } else if (operation < 30) {
+                        size_t size = vec.size();
+                        if (size == 0) continue;
+                        vec.write(op % size, op);
+                    }
+                } catch (const std::out_of_range&) {}
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    static const char* state_names[] = {"empty", "raw", "mapped", "frozen", "spilled"};
+    MemoryStats stats = vec.memory_stats();
+    std::cout << "size " << vec.size() << ", live " << stats.live_bytes_ << " B, buckets "
+              << stats.bucket_bytes_ << " B, slack " << stats.slack_bytes_ << " B\n"
+              << "unreclaimed descriptors: " << stats.descriptors_ << " (" << stats.descriptor_bytes_ << " B)\n";
+    for (size_t i = 0; i < LockFreeVector<int>::MAX_BUCKETS; ++i) {
+        const BucketMemoryStats& bucket = stats.buckets_[i];
+        if (bucket.state_ == BucketState::EMPTY) continue;
+        std::cout << "  bucket " << std::setw(2) << i << ": " << state_names[static_cast<int>(bucket.state_)]
+                  << ", " << bucket.used_ << "/" << bucket.capacity_ << " used, "
+                  << bucket.resident_bytes_ << " B\n";
+    }
+}
+
+// heap allocations behind each operation, single threaded so nothing is lost to retries. with
+// LFV_ALLOC_ASSERT set, read, write and size run inside a NoAllocationScope and abort if they allocate
+void run_allocation_profile(int num_ops) {
+    bool assert_mode = std::getenv("LFV_ALLOC_ASSERT") != nullptr;
+    LockFreeVector<int> vec;
+    for (int i = 0; i < num_ops; ++i) vec.push_back(i);
+
+    auto profile = [&](const char* name, bool allocation_free, auto&& op) {
+        AllocationCounts before = AllocationTracker::totals();
+        {
+            NoAllocationScope scope(assert_mode && allocation_free);
+            for (int i = 0; i < num_ops; ++i) op(i);
+        }
+        AllocationCounts used = AllocationTracker::totals() - before;
+        std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(8) << static_cast<double>(used.allocations_) / num_ops << " allocs/op "
+                  << std::setw(9) << static_cast<double>(used.bytes_) / num_ops << " bytes/op"
+                  << (assert_mode && allocation_free ? "  (asserted)" : "") << "\n";
+    };
+
+    volatile int sink = 0;
+    profile("push_back", false, [&](int i) { vec.push_back(i); });
+    profile("read", true, [&](int i) { sink = vec.read(i); });
+    profile("write", true, [&](int i) { vec.write(i, i); });
+    profile("size", true, [&](int) { sink = static_cast<int>(vec.size()); });
+    profile("pop_back", false, [&](int) { sink = vec.pop_back(); });
+}
+
+// the mixed workload of run_mixed_ops_benchmark through a RecordingVector, saved for replay
+void record_mixed_ops_trace(const std::string& path, int num_threads, int ops_per_thread) {
+    RecordingVector<int> vec;
+    for (int i = 0; i < 10000; ++i) vec.push_back(i);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&vec, ops_per_thread, t]() {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<> op_dist(0, 99);
+            std::uniform_int_distribution<> val_dist(0, 1000);
+            for (int op = 0; op < ops_per_thread; ++op) {
+                int operation = op_dist(gen);
+                try {
+                    if (operation < 15) {
+                        vec.push_back(val_dist(gen));
+                    } else if (operation < 20) {
+                        vec.pop_back();
+                    } else {
+                        size_t size = vec.size();
+                        if (size == 0) continue;
+                        if (operation < 30) vec.write(val_dist(gen) % size, val_dist(gen));
+                        else vec.read(val_dist(gen) % size);
+                    }
+                } catch (const std::out_of_range&) {}
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    vec.save_trace(path);
+}
+
+// re-issues a recorded trace on num_threads threads, thread t plays streams t, t + num_threads, ...
+// back to back. paced waits out the recorded gap before each operation, otherwise the streams run
+// as fast as the vector allows. indices past the current size wrap, the replay can drift from the
+// recording when threads interleave differently
+template<typename VectorType>
+BenchmarkStats run_trace_replay(const OpTrace& trace, int num_threads, int num_runs, bool paced) {
+    std::vector<double> times;
+    times.reserve(num_runs);
+
+    for (int run = 0; run < num_runs; ++run) {
+        std::unique_ptr<VectorWrapper<int>> vec = std::make_unique<VectorType>();
+        std::vector<std::thread> threads;
+        auto start_time = high_resolution_clock::now();
+
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&vec, &trace, num_threads, paced, t]() {
+                size_t known_size = 0;
+                auto next = high_resolution_clock::now();
+                for (size_t s = t; s < trace.streams_.size(); s += num_threads) {
+                    for (const TracedOp& op : trace.streams_[s]) {
+                        if (paced) {
+                            next += nanoseconds(op.delay_ns_);
+                            std::this_thread::sleep_until(next);
+                        }
+                        try {
+                            switch (op.op_) {
+                                case TracedOpKind::PUSH_BACK:
+                                    vec->push_back(static_cast<int>(op.value_));
+                                    break;
+                                case TracedOpKind::POP_BACK:
+                                    vec->pop_back();
+                                    break;
+                                case TracedOpKind::SIZE:
+                                    known_size = vec->size();
+                                    break;
+                                case TracedOpKind::READ:
+                                case TracedOpKind::WRITE: {
+                                    size_t index = op.index_;
+                                    if (index >= known_size) known_size = vec->size();
+                                    if (known_size == 0) break;
+                                    if (index >= known_size) index %= known_size;
+                                    if (op.op_ == TracedOpKind::WRITE) {
+                                        vec->write(index, static_cast<int>(op.value_));
+                                    } else {
+                                        volatile auto val = vec->read(index);
+                                        (void)val;
+                                    }
+                                    break;
+                                }
+                            }
+                        } catch (const std::out_of_range&) {}
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        auto duration = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count();
+        times.push_back(static_cast<double>(duration));
+    }
+
+    BenchmarkStats stats;
+    stats.calculate(times);
+    return stats;
+}
+
+// per-operation cost on the template harness: concrete types, pinned persistent threads, a start
+// barrier and precomputed streams. LockFreeVector is called directly, the wrappers are final so
+// their calls are devirtualized as well
+void run_devirtualized_benchmark(const std::vector<int>& thread_counts, size_t ops_per_thread, int num_runs) {
+    PinnedThreadPool pool(*std::max_element(thread_counts.begin(), thread_counts.end()));
+    const std::pair<const char*, HarnessMix> mixes[] = {
+        {"mixed", {15, 5, 10}}, {"read", {0, 0, 0}}, {"write", {0, 0, 100}}, {"push_back", {100, 0, 0}}};
+
+    for (int num_threads : thread_counts) {
+        std::cout << "\n" << num_threads << " threads, median ns/op per thread:\n" << std::setw(20) << "";
+        for (const auto& [name, mix] : mixes) std::cout << std::setw(11) << name;
+        std::cout << "\n";
+
+        std::vector<HarnessStreams> streams;
+        for (const auto& [name, mix] : mixes) streams.emplace_back(num_threads, ops_per_thread, mix, 10000);
+
+        auto row = [&]<typename VectorType>(const char* label) {
+            std::cout << std::left << std::setw(20) << label << std::right << std::fixed << std::setprecision(1);
+            for (const HarnessStreams& stream : streams) {
+                std::vector<double> ns = run_harness<VectorType>(pool, stream, num_runs);
+                std::sort(ns.begin(), ns.end());
+                std::cout << std::setw(11) << ns[ns.size() / 2];
+            }
+            std::cout << "\n";
+        };
+        row.template operator()<LockFreeVector<int>>("LockFreeVector");
+        row.template operator()<LockFreeVectorWrapper<int>>("LockFreeVector (wr)");
+        row.template operator()<MutexVectorWrapper<int>>("Mutex");
+        row.template operator()<SpinlockVectorWrapper<int>>("Spinlock");
+        row.template operator()<SegmentedVectorWrapper<int>>("Segmented");
+        row.template operator()<RcuVectorWrapper<int>>("RCU");
+    }
+}
+
+struct TradeRecord {
+    int64_t timestamp_;
+    int64_t price_;
+    int64_t quantity_;
+    int64_t order_id_;
+    int64_t account_id_;
+    int64_t venue_;
+    int64_t flags_;
+    int64_t sequence_;
+};
+
+// sums one field of an 8-field record, row layout vs one column of the struct-of-arrays vector
+void run_columnar_benchmark(size_t num_records, int num_runs) {
+    using Columnar = ColumnarLockFreeVector<int64_t, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t>;
+    LockFreeVector<TradeRecord> rows;
+    Columnar columns;
+    for (size_t i = 0; i < num_records; ++i) {
+        int64_t v = static_cast<int64_t>(i);
+        rows.push_back({v, v * 3, 1, v, 7, 2, 0, v});
+        columns.push_back(v, v * 3, 1, v, 7, 2, 0, v);
+    }
+
+    auto time_ns = [&](auto&& aggregate) {
+        std::vector<double> per_element;
+        int64_t result = 0;
+        for (int run = 0; run < num_runs; ++run) {
+            auto start_time = high_resolution_clock::now();
+            result += aggregate();
+            auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count();
+            per_element.push_back(static_cast<double>(elapsed) / num_records);
+        }
+        volatile int64_t sink = result;
+        (void)sink;
+        std::sort(per_element.begin(), per_element.end());
+        return per_element[per_element.size() / 2];
+    };
+
+    double row_ns = time_ns([&] {
+        int64_t sum = 0;
+        for (size_t i = 0; i < num_records; ++i) sum += rows.read(i).price_;
+        return sum;
+    });
+    double column_read_ns = time_ns([&] {
+        int64_t sum = 0;
+        for (size_t i = 0; i < num_records; ++i) sum += columns.read<1>(i);
+        return sum;
+    });
+    double column_scan_ns = time_ns([&] {
+        int64_t sum = 0;
+        columns.scan<1>(0, num_records, [&](const int64_t* data, size_t count) {
+            for (size_t i = 0; i < count; ++i) sum += data[i];
+        });
+        return sum;
+    });
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "LockFreeVector<Record> read:  " << row_ns << " ns/element\n"
+              << "columnar read<1>:             " << column_read_ns << " ns/element\n"
+              << "columnar scan<1>:             " << column_scan_ns << " ns/element\n";
+}
+
 int main() {
     const int NUM_RUNS = 25;
+#ifdef LFV_TRACE
+    // kill -USR2 <pid> dumps the flight recorder mid-run, convert with lfv_trace2json
+    FlightRecorder::install_signal_handler("lfv_flight.bin");
+#endif
     std::vector<int> thread_counts = {2, 4, 6};
 
     std::cout << "\n=== Vector Performance Benchmark ===\n";
@@ -207,14 +1349,134 @@ int main() {
 
     for (int num_threads : thread_counts) {
         std::cout << "\nTesting with " << num_threads << " threads:\n";
+        result_context = std::to_string(num_threads) + " threads";
 
         std::cout << "\nLock-Free Vector:";
         auto lockfree_stats = run_mixed_ops_benchmark<LockFreeVectorWrapper<int>>(num_threads, NUM_RUNS);
         print_stats("Lock-Free Vector Results", lockfree_stats);
 
+        std::cout << "\nShared-Memory Lock-Free Vector:";
+        auto shared_stats = run_mixed_ops_benchmark<SharedLockFreeVectorWrapper<int>>(num_threads, NUM_RUNS);
+        print_stats("Shared-Memory Lock-Free Vector Results", shared_stats);
+
         std::cout << "\nMutex Vector:";
         auto mutex_stats = run_mixed_ops_benchmark<MutexVectorWrapper<int>>(num_threads, NUM_RUNS);
         print_stats("Mutex Vector Results", mutex_stats);
+
+        std::cout << "\nSpinlock Vector:";
+        print_stats("Spinlock Vector Results", run_mixed_ops_benchmark<SpinlockVectorWrapper<int>>(num_threads, NUM_RUNS));
+
+        std::cout << "\nShared-Mutex Vector:";
+        print_stats("Shared-Mutex Vector Results", run_mixed_ops_benchmark<SharedMutexVectorWrapper<int>>(num_threads, NUM_RUNS));
+
+        std::cout << "\nSegmented Vector:";
+        print_stats("Segmented Vector Results", run_mixed_ops_benchmark<SegmentedVectorWrapper<int>>(num_threads, NUM_RUNS));
+
+        std::cout << "\nRCU Vector:";
+        print_stats("RCU Vector Results", run_mixed_ops_benchmark<RcuVectorWrapper<int>>(num_threads, NUM_RUNS));
+#ifdef LFV_HAVE_TBB
+        std::cout << "\ntbb::concurrent_vector (no pop_back):";
+        print_stats("tbb::concurrent_vector Results", run_mixed_ops_benchmark<TbbVectorWrapper<int>>(num_threads, NUM_RUNS));
+#endif
+    }
+
+    std::cout << "\n=== Devirtualized Harness (pinned pool, precomputed streams) ===\n";
+    run_devirtualized_benchmark(thread_counts, 200000, 7);
+
+    std::cout << "\n=== FIFO Queue Benchmark ===\n";
+    for (int num_threads : thread_counts) {
+        std::cout << "\nTesting with " << num_threads << " threads:\n";
+        result_context = std::to_string(num_threads) + " threads";
+
+        std::cout << "\nLock-Free Queue: ";
+        auto queue_stats = run_queue_benchmark<LockFreeQueueWrapper<int>>(num_threads, NUM_RUNS);
+        print_stats("Lock-Free Queue Results", queue_stats);
+
+        std::cout << "\nMutex Queue: ";
+        auto mutex_queue_stats = run_queue_benchmark<MutexQueueWrapper<int>>(num_threads, NUM_RUNS);
+        print_stats("Mutex Queue Results", mutex_queue_stats);
+
+        std::cout << "\nLock-Free Vector + Head Index: ";
+        auto vector_queue_stats = run_queue_benchmark<VectorHeadQueueWrapper<int>>(num_threads, NUM_RUNS);
+        print_stats("Lock-Free Vector + Head Index Results", vector_queue_stats);
+    }
+
+
+    std::cout << "\n=== Durable Append Benchmark ===\n";
+    for (size_t max_batch : {1, 16, 256}) {
+        for (int num_threads : thread_counts) {
+            std::cout << "\nmax batch " << max_batch << ", " << num_threads << " threads: ";
+            result_context = "max batch " + std::to_string(max_batch) + ", " + std::to_string(num_threads) + " threads";
+            auto durable_stats = run_durable_append_benchmark(num_threads, max_batch, 5);
+            print_stats("Durable Append Results", durable_stats);
+        }
+    }
+
+    result_context.clear();
+
+    std::cout << "\n=== Cold Start Benchmark (" << (1 << 22) << " elements) ===\n";
+    run_cold_start_benchmark(1 << 22, 5);
+
+    std::cout << "\n=== Snapshot Benchmark (" << (1 << 24) << " x int64) ===\n";
+    run_snapshot_benchmark(1 << 24, 5);
+
+    std::cout << "\n=== Incremental Checkpoint Benchmark (" << (1 << 24) << " x int64) ===\n";
+    run_checkpoint_benchmark(1 << 24, 5);
+
+    std::cout << "\n=== Frozen Bucket Benchmark (" << (8 << 21) - 8 << " x int64 timestamps) ===\n";
+    run_frozen_bucket_benchmark(21);
+
+    std::cout << "\n=== Tiered Storage Benchmark (" << (8 << 20) - 8 << " x int64) ===\n";
+    run_tiered_storage_benchmark(20, 20);
+
+    std::cout << "\n=== Columnar Sum Benchmark (" << (1 << 22) << " x 8-field records) ===\n";
+    run_columnar_benchmark(1 << 22, 9);
+
+    for (int num_threads : thread_counts) {
+        std::cout << "\n=== Contention Stats (" << num_threads << " threads) ===\n";
+        run_contention_stats_report(num_threads, 200000);
+    }
+
+    for (int num_threads : thread_counts) {
+        std::cout << "\n=== Operation Latency (" << num_threads << " threads) ===\n";
+        run_latency_report(num_threads, 200000);
+    }
+
+    std::cout << "\n=== Memory Accounting (4 threads, mixed ops) ===\n";
+    run_memory_accounting_report(4);
+
+    std::cout << "\n=== Allocation Profile (" << 100000 << " ops each) ===\n";
+    run_allocation_profile(100000);
+
+    // LFV_OP_TRACE replays a recorded trace instead of the synthetic one
+    const char* trace_path = std::getenv("LFV_OP_TRACE");
+    if (!trace_path) {
+        trace_path = "lfv_ops.trace";
+        record_mixed_ops_trace(trace_path, 4, 100000);
+    }
+    OpTrace trace = load_op_trace(trace_path);
+    std::cout << "\n=== Trace Replay (" << trace_path << ", " << trace.streams_.size() << " streams, "
+              << trace.ops() << " ops, " << std::filesystem::file_size(trace_path) << " bytes) ===\n";
+    for (int num_threads : thread_counts) {
+        std::cout << "\nReplaying on " << num_threads << " threads:\n";
+        result_context = std::to_string(num_threads) + " threads";
+        print_stats("Lock-Free Vector Replay", run_trace_replay<LockFreeVectorWrapper<int>>(trace, num_threads, 5, false));
+        print_stats("Mutex Vector Replay", run_trace_replay<MutexVectorWrapper<int>>(trace, num_threads, 5, false));
+    }
+    result_context.clear();
+    std::cout << "\nPaced replay, one thread per stream:\n";
+    print_stats("Lock-Free Vector Paced Replay",
+                run_trace_replay<LockFreeVectorWrapper<int>>(trace, static_cast<int>(trace.streams_.size()), 1, true));
+
+#ifdef LFV_TRACE
+    FlightRecorder::dump("lfv_flight.bin");
+    std::cout << "\nflight recorder dumped to lfv_flight.bin\n";
+#endif
+
+    // LFV_RESULTS=before.json, change, LFV_RESULTS=after.json, then lfv_compare before.json after.json
+    if (const char* results_path = std::getenv("LFV_RESULTS")) {
+        write_results_json(results_path);
+        std::cout << "\nresults written to " << results_path << "\n";
     }
 
     return 0;
@@ -0,0 +1,157 @@
+// per-operation microbenchmarks on google benchmark, built as lfv_microbench.
+// every benchmark runs for each element type, initial size and thread count from 1 up to
+// hardware concurrency; threads share one vector. time is wall clock per operation, items/s is
+// the aggregate rate over all threads
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "lock-free-vector.cpp"
+
+struct Payload16 {
+    int64_t key_;
+    int64_t value_;
+};
+
+namespace {
+
+template <typename T>
+T make_value(size_t i) {
+    if constexpr (std::is_same_v<T, Payload16>) {
+        return {static_cast<int64_t>(i), static_cast<int64_t>(i)};
+    } else {
+        return static_cast<T>(i);
+    }
+}
+
+// one vector per benchmark run, created and destroyed by thread 0. google benchmark holds every
+// thread at a barrier before and after the timed loop, so the others never see it half built
+template <typename T>
+LockFreeVector<T>* shared_vector = nullptr;
+
+template <typename T>
+void setup(const benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        shared_vector<T> = new LockFreeVector<T>();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            shared_vector<T>->push_back(make_value<T>(static_cast<size_t>(i)));
+        }
+    }
+}
+
+template <typename T>
+void teardown(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete shared_vector<T>;
+        shared_vector<T> = nullptr;
+    }
+}
+
+// precomputed so the timed loop measures the vector rather than the generator
+std::vector<size_t> random_indices(size_t bound, uint64_t seed) {
+    std::vector<size_t> indices(1 << 16);
+    std::mt19937_64 gen(seed);
+    std::uniform_int_distribution<size_t> dist(0, bound - 1);
+    for (auto& index : indices) index = dist(gen);
+    return indices;
+}
+
+template <typename T>
+void BM_PushBack(benchmark::State& state) {
+    setup<T>(state);
+    T value = make_value<T>(1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_vector<T>->push_back(value));
+    }
+    teardown<T>(state);
+}
+
+template <typename T>
+void BM_PopBack(benchmark::State& state) {
+    setup<T>(state);
+    for (auto _ : state) {
+        try {
+            benchmark::DoNotOptimize(shared_vector<T>->pop_back());
+        } catch (const std::out_of_range&) {
+            // drained, refill outside the timed region
+            state.PauseTiming();
+            for (int64_t i = 0; i < std::max<int64_t>(state.range(0), 1024); ++i) {
+                shared_vector<T>->push_back(make_value<T>(static_cast<size_t>(i)));
+            }
+            state.ResumeTiming();
+        }
+    }
+    teardown<T>(state);
+}
+
+template <typename T>
+void BM_Read(benchmark::State& state) {
+    setup<T>(state);
+    std::vector<size_t> indices = random_indices(static_cast<size_t>(state.range(0)), state.thread_index());
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_vector<T>->read(indices[i++ & 0xffff]));
+    }
+    teardown<T>(state);
+}
+
+template <typename T>
+void BM_Write(benchmark::State& state) {
+    setup<T>(state);
+    std::vector<size_t> indices = random_indices(static_cast<size_t>(state.range(0)), state.thread_index());
+    T value = make_value<T>(7);
+    size_t i = 0;
+    for (auto _ : state) {
+        shared_vector<T>->write(indices[i++ & 0xffff], value);
+    }
+    teardown<T>(state);
+}
+
+template <typename T>
+void BM_Size(benchmark::State& state) {
+    setup<T>(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_vector<T>->size());
+    }
+    teardown<T>(state);
+}
+
+// at() is the bucket/index math plus one load, walked sequentially across bucket boundaries
+template <typename T>
+void BM_AtSequential(benchmark::State& state) {
+    setup<T>(state);
+    size_t bound = static_cast<size_t>(state.range(0));
+    size_t i = static_cast<size_t>(state.thread_index());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&shared_vector<T>->at(i));
+        if (++i == bound) i = 0;
+    }
+    teardown<T>(state);
+}
+
+void configure(benchmark::internal::Benchmark* bench) {
+    int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bench->ArgName("size")->Arg(1 << 10)->Arg(1 << 20)->ThreadRange(1, max_threads)->UseRealTime();
+}
+
+}  // namespace
+
+#define LFV_BENCH_ALL_TYPES(bench)                        \
+    BENCHMARK_TEMPLATE(bench, int32_t)->Apply(configure); \
+    BENCHMARK_TEMPLATE(bench, int64_t)->Apply(configure); \
+    BENCHMARK_TEMPLATE(bench, double)->Apply(configure);  \
+    BENCHMARK_TEMPLATE(bench, Payload16)->Apply(configure)
+
+LFV_BENCH_ALL_TYPES(BM_PushBack);
+LFV_BENCH_ALL_TYPES(BM_PopBack);
+LFV_BENCH_ALL_TYPES(BM_Read);
+LFV_BENCH_ALL_TYPES(BM_Write);
+LFV_BENCH_ALL_TYPES(BM_Size);
+LFV_BENCH_ALL_TYPES(BM_AtSequential);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,84 @@
+// top-like view of the vectors a process exports with export_live_stats().
+// usage: lfv_monitor <pid> [seconds]    (runs until interrupted without a limit)
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "live-stats.cpp"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <pid> [seconds]\n";
+        return 2;
+    }
+    pid_t pid = static_cast<pid_t>(std::atoi(argv[1]));
+    long seconds = argc > 2 ? std::atol(argv[2]) : -1;
+
+    std::string name = live_stats_segment_name(pid);
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "no live stats for pid " << pid << " (" << name << ")\n";
+        return 1;
+    }
+    void* p = ::mmap(nullptr, sizeof(LiveStatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::cerr << "mmap failed\n";
+        return 1;
+    }
+    const LiveStatsSegment* segment = static_cast<const LiveStatsSegment*>(p);
+    if (segment->magic_ != LIVE_STATS_MAGIC || segment->version_ != LIVE_STATS_VERSION) {
+        std::cerr << name << ": unknown segment format\n";
+        return 1;
+    }
+
+    LiveStatsSample previous[LIVE_STATS_SLOTS] = {};
+    bool seen[LIVE_STATS_SLOTS] = {};
+    for (long tick = 0; seconds < 0 || tick <= seconds; tick++) {
+        // clear screen and home the cursor, like top
+        std::cout << "\033[2J\033[H" << "pid " << pid << "\n\n"
+                  << std::left << std::setw(24) << "vector" << std::right
+                  << std::setw(12) << "size" << std::setw(12) << "capacity" << std::setw(8) << "buckets"
+                  << std::setw(12) << "push+pop/s" << std::setw(12) << "reads/s" << std::setw(12) << "writes/s"
+                  << std::setw(10) << "cas fail" << "\n";
+
+        for (uint32_t i = 0; i < LIVE_STATS_SLOTS; i++) {
+            LiveStatsSample sample;
+            if (!read_live_stats(segment->slots_[i], sample)) {
+                seen[i] = false;
+                continue;
+            }
+
+            // rates need two samples of the same vector
+            double elapsed = seen[i] && sample.sampled_ns_ > previous[i].sampled_ns_
+                             ? static_cast<double>(sample.sampled_ns_ - previous[i].sampled_ns_) / 1e9 : 0.0;
+            auto rate = [&](uint64_t now, uint64_t before) {
+                return elapsed > 0 && now >= before ? static_cast<double>(now - before) / elapsed : 0.0;
+            };
+            uint64_t attempts = sample.cas_attempts_ - (seen[i] ? previous[i].cas_attempts_ : 0);
+            uint64_t failures = sample.cas_failures_ - (seen[i] ? previous[i].cas_failures_ : 0);
+
+            std::cout << std::left << std::setw(24) << sample.name_ << std::right << std::fixed << std::setprecision(0)
+                      << std::setw(12) << sample.size_ << std::setw(12) << sample.capacity_
+                      << std::setw(8) << sample.buckets_
+                      << std::setw(12) << rate(sample.operations_, previous[i].operations_)
+                      << std::setw(12) << rate(sample.reads_, previous[i].reads_)
+                      << std::setw(12) << rate(sample.writes_, previous[i].writes_)
+                      << std::setw(9) << std::setprecision(1)
+                      << (attempts ? 100.0 * static_cast<double>(failures) / static_cast<double>(attempts) : 0.0) << "%\n";
+
+            previous[i] = sample;
+            seen[i] = true;
+        }
+        std::cout << std::flush;
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "lock-free-vector.cpp"
+
+// operation traces: RecordingVector records what every thread does to a vector, load_op_trace
+// reads it back for replay (run_trace_replay in main.cpp). file layout:
+//   OpTraceFileHeader | per thread: OpTraceStreamHeader | encoded records
+// a record is the op byte, the ns since the thread's previous operation as a varint, then the
+// index (read, write) as a varint and the value (push, write) as a zigzag varint, 2-6 bytes for
+// typical traffic
+
+static constexpr uint64_t OP_TRACE_MAGIC = 0x315254504f56464cULL; // "LFVOPTR1"
+static constexpr uint32_t OP_TRACE_VERSION = 1;
+
+enum class TracedOpKind : uint8_t { PUSH_BACK, POP_BACK, READ, WRITE, SIZE };
+
+struct TracedOp {
+    uint64_t delay_ns_;    // since the previous operation of the same thread, or since recording began
+    uint64_t index_;
+    int64_t value_;
+    TracedOpKind op_;
+};
+
+struct OpTraceFileHeader {
+    uint64_t magic_;
+    uint32_t version_;
+    uint32_t streams_;
+};
+
+struct OpTraceStreamHeader {
+    uint64_t ops_;
+    uint64_t bytes_;
+};
+
+// one vector of operations per recorded thread
+struct OpTrace {
+    std::vector<std::vector<TracedOp>> streams_;
+
+    size_t ops() const {
+        size_t total = 0;
+        for (const auto& stream : streams_) total += stream.size();
+        return total;
+    }
+};
+
+// per-thread encoded streams. a thread finds its stream through a one-entry thread_local cache,
+// the mutex is only taken on a thread's first operation against a recorder
+class OpTraceRecorder {
+    struct Stream {
+        std::thread::id thread_;
+        std::vector<uint8_t> bytes_;
+        uint64_t ops_ = 0;
+        std::chrono::steady_clock::time_point last_;
+    };
+
+    static inline std::atomic<uint64_t> next_id_{1};
+
+    const uint64_t id_ = next_id_.fetch_add(1, std::memory_order_relaxed);
+    const std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+
+    Stream& stream() {
+        thread_local uint64_t cached_id = 0;
+        thread_local Stream* cached = nullptr;
+        if (cached_id == id_) return *cached;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::thread::id self = std::this_thread::get_id();
+        cached = nullptr;
+        for (auto& stream : streams_) {
+            if (stream->thread_ == self) cached = stream.get();
+        }
+        if (!cached) {
+            streams_.push_back(std::make_unique<Stream>());
+            cached = streams_.back().get();
+            cached->thread_ = self;
+            cached->last_ = start_;
+        }
+        cached_id = id_;
+        return *cached;
+    }
+
+    static void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+public:
+    void record(TracedOpKind op, uint64_t index = 0, int64_t value = 0) {
+        Stream& s = stream();
+        auto now = std::chrono::steady_clock::now();
+        s.bytes_.push_back(static_cast<uint8_t>(op));
+        put_varint(s.bytes_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - s.last_).count()));
+        if (op == TracedOpKind::READ || op == TracedOpKind::WRITE) put_varint(s.bytes_, index);
+        if (op == TracedOpKind::PUSH_BACK || op == TracedOpKind::WRITE) {
+            put_varint(s.bytes_, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        }
+        s.last_ = now;
+        s.ops_++;
+    }
+
+    // call once the recorded threads are done
+    void save(const std::string& path) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("cannot open " + path);
+        OpTraceFileHeader header{OP_TRACE_MAGIC, OP_TRACE_VERSION, static_cast<uint32_t>(streams_.size())};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& stream : streams_) {
+            OpTraceStreamHeader stream_header{stream->ops_, stream->bytes_.size()};
+            out.write(reinterpret_cast<const char*>(&stream_header), sizeof(stream_header));
+            out.write(reinterpret_cast<const char*>(stream->bytes_.data()), static_cast<std::streamsize>(stream->bytes_.size()));
+        }
+        if (!out.flush()) throw std::runtime_error("write failed: " + path);
+    }
+};
+
+inline OpTrace load_op_trace(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + path);
+    OpTraceFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic_ != OP_TRACE_MAGIC
+        || header.version_ != OP_TRACE_VERSION) {
+        throw std::runtime_error(path + ": not an operation trace");
+    }
+
+    OpTrace trace;
+    trace.streams_.resize(header.streams_);
+    std::vector<uint8_t> bytes;
+    for (auto& ops : trace.streams_) {
+        OpTraceStreamHeader stream_header;
+        if (!in.read(reinterpret_cast<char*>(&stream_header), sizeof(stream_header))) {
+            throw std::runtime_error(path + ": truncated");
+        }
+        bytes.resize(stream_header.bytes_);
+        if (!in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+            throw std::runtime_error(path + ": truncated");
+        }
+
+        size_t pos = 0;
+        auto get_varint = [&]() {
+            uint64_t v = 0;
+            for (int shift = 0; ; shift += 7) {
+                if (pos == bytes.size() || shift > 63) throw std::runtime_error(path + ": corrupt record");
+                uint8_t b = bytes[pos++];
+                v |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) return v;
+            }
+        };
+        ops.reserve(stream_header.ops_);
+        while (pos < bytes.size()) {
+            TracedOp op{};
+            op.op_ = static_cast<TracedOpKind>(bytes[pos++]);
+            if (op.op_ > TracedOpKind::SIZE) throw std::runtime_error(path + ": corrupt record");
+            op.delay_ns_ = get_varint();
+            if (op.op_ == TracedOpKind::READ || op.op_ == TracedOpKind::WRITE) op.index_ = get_varint();
+            if (op.op_ == TracedOpKind::PUSH_BACK || op.op_ == TracedOpKind::WRITE) {
+                uint64_t zigzag = get_varint();
+                op.value_ = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            }
+            ops.push_back(op);
+        }
+        if (ops.size() != stream_header.ops_) throw std::runtime_error(path + ": corrupt stream");
+    }
+    return trace;
+}
+
+// forwards to Vector and records every call. values are stored as int64, so T has to be integral
+template <typename T, typename Vector = LockFreeVector<T>>
+class RecordingVector {
+    static_assert(std::is_integral_v<T>, "traces store values as int64");
+
+    Vector vec_;
+    OpTraceRecorder recorder_;
+
+public:
+    template <typename... Args>
+    explicit RecordingVector(Args&&... args) : vec_(std::forward<Args>(args)...) {}
+
+    size_t push_back(const T& elem) {
+        recorder_.record(TracedOpKind::PUSH_BACK, 0, static_cast<int64_t>(elem));
+        return vec_.push_back(elem);
+    }
+
+    T pop_back() {
+        recorder_.record(TracedOpKind::POP_BACK);
+        return vec_.pop_back();
+    }
+
+    T read(size_t i) {
+        recorder_.record(TracedOpKind::READ, i);
+        return vec_.read(i);
+    }
+
+    void write(size_t i, const T& elem) {
+        recorder_.record(TracedOpKind::WRITE, i, static_cast<int64_t>(elem));
+        vec_.write(i, elem);
+    }
+
+    size_t size() {
+        recorder_.record(TracedOpKind::SIZE);
+        return vec_.size();
+    }
+
+    Vector& vector() { return vec_; }
+
+    void save_trace(const std::string& path) const { recorder_.save(path); }
+};
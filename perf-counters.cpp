@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// hardware counters around a benchmark region through perf_event_open. every event is opened on
+// its own, user space only, inherited by threads created after open(), so counters cover the
+// worker threads once they have been joined. events the kernel or the machine refuses are skipped,
+// when perf_event_paranoid or a missing PMU (most VMs) refuses all of them available() is false
+// and error() says why.
+//
+// there is no portable event for cache-to-cache transfers of modified lines (HITM). set
+// LFV_PERF_HITM to the raw event code of this CPU, e.g. 0x04d2 (MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM)
+// on Skylake, to count it as well
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, DTLB_MISSES, HITM, NUM_EVENTS };
+
+    struct Sample {
+        bool valid_[NUM_EVENTS] = {};
+        uint64_t counts_[NUM_EVENTS] = {};
+
+        double ipc() const {
+            return valid_[CYCLES] && valid_[INSTRUCTIONS] && counts_[CYCLES]
+                   ? static_cast<double>(counts_[INSTRUCTIONS]) / static_cast<double>(counts_[CYCLES]) : 0.0;
+        }
+    };
+
+private:
+    struct Raw {
+        bool valid_ = false;
+        uint64_t value_ = 0;
+        uint64_t enabled_ = 0;
+        uint64_t running_ = 0;
+    };
+
+    int fds_[NUM_EVENTS];
+    Raw begin_[NUM_EVENTS];
+    Sample total_;
+    std::string error_;
+
+    void read_raw(Raw* raw) const {
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            uint64_t values[3];   // value, time enabled, time running
+            raw[e].valid_ = fds_[e] >= 0 && ::read(fds_[e], values, sizeof(values)) == static_cast<ssize_t>(sizeof(values));
+            if (!raw[e].valid_) continue;
+            raw[e].value_ = values[0];
+            raw[e].enabled_ = values[1];
+            raw[e].running_ = values[2];
+        }
+    }
+
+    static constexpr uint64_t cache_event(uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    static int open_event(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+public:
+    PerfCounters() {
+        struct { uint32_t type_; uint64_t config_; } events[NUM_EVENTS] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB)},
+            {PERF_TYPE_RAW, 0},
+        };
+        const char* hitm = std::getenv("LFV_PERF_HITM");
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            fds_[e] = -1;
+            if (e == HITM) {
+                if (!hitm) continue;
+                events[e].config_ = std::strtoull(hitm, nullptr, 0);
+            }
+            fds_[e] = open_event(events[e].type_, events[e].config_);
+            if (fds_[e] < 0 && error_.empty()) error_ = std::strerror(errno);
+        }
+        if (available()) error_.clear();
+        else if (error_.empty()) error_ = "no events";
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (int fd : fds_) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    const std::string& error() const { return error_; }
+
+    // counts accumulate over every start/stop pair. the kernel does not clear what exited threads
+    // folded into an inherited counter on PERF_EVENT_IOC_RESET, so each region is a difference of reads
+    void start() {
+        read_raw(begin_);
+        for (int fd : fds_) {
+            if (fd >= 0) ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop() {
+        for (int fd : fds_) {
+            if (fd >= 0) ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        Raw end[NUM_EVENTS];
+        read_raw(end);
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            if (!end[e].valid_ || !begin_[e].valid_) continue;
+            uint64_t value = end[e].value_ - begin_[e].value_;
+            uint64_t enabled = end[e].enabled_ - begin_[e].enabled_;
+            uint64_t running = end[e].running_ - begin_[e].running_;
+            // scale up when the PMU was multiplexed between more events than it has counters
+            if (running > 0 && running < enabled) {
+                value = static_cast<uint64_t>(static_cast<double>(value) * static_cast<double>(enabled) / static_cast<double>(running));
+            }
+            total_.valid_[e] = true;
+            total_.counts_[e] += value;
+        }
+    }
+
+    void reset() { total_ = Sample(); }
+
+    const Sample& read() const { return total_; }
+};
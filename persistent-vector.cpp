@@ -0,0 +1,224 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lock-free-vector.cpp"
+
+// storage policy that places every bucket in its own page-aligned region of one file, mapped
+// MAP_SHARED. the file starts with a header page holding the (counter, size) pair of the latest
+// descriptor, so reopening the file gives back the vector without reading any elements.
+//
+// crash consistency: elements are always written before the header state that covers them, so
+// after a process crash state_ is accurate. if the machine went down (the boot id changed) only
+// synced_state_ is trusted, which sync() advances after the bucket data has been flushed
+template <typename T>
+class MappedFileStorage {
+    static_assert(std::is_trivially_copyable_v<T>, "MappedFileStorage maps raw bytes of T");
+
+private:
+    static constexpr uint32_t MAX_BUCKETS = 32;
+    static constexpr uint64_t MAGIC = 0x31304d5056564c46ULL; // "FLVVPM01"
+    static constexpr uint32_t VERSION = 1;
+
+    struct FileHeader {
+        uint64_t magic_;
+        uint32_t version_;
+        uint32_t elem_size_;
+        uint64_t alignment_;
+        std::atomic<uint64_t> state_;          // counter << 32 | size of the newest published descriptor
+        std::atomic<uint64_t> synced_state_;   // state_ as of the last completed sync()
+        std::atomic<uint32_t> clean_;          // set on orderly close, state_ can then be trusted as is
+        char boot_id_[40];                     // kernel boot the file was last opened in
+    };
+
+    int fd_;
+    FileHeader* header_;
+    size_t alignment_;
+    off_t offsets_[MAX_BUCKETS + 1];
+
+    [[noreturn]] static void throw_errno(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    static uint64_t pack(size_t size, uint32_t counter) {
+        return (static_cast<uint64_t>(counter) << 32) | static_cast<uint32_t>(size);
+    }
+
+    // page cache contents only survive within one boot
+    static bool read_boot_id(char (&id)[40]) {
+        std::memset(id, 0, sizeof(id));
+        int fd = ::open("/proc/sys/kernel/random/boot_id", O_RDONLY);
+        if (fd < 0) return false;
+        ssize_t n = ::read(fd, id, sizeof(id) - 1);
+        ::close(fd);
+        return n > 0;
+    }
+
+    void compute_offsets(size_t first_bucket_size) {
+        offsets_[0] = static_cast<off_t>(alignment_);
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            size_t bytes = first_bucket_size * (1UL << i) * sizeof(T);
+            offsets_[i + 1] = offsets_[i] + static_cast<off_t>((bytes + alignment_ - 1) / alignment_ * alignment_);
+        }
+    }
+
+    T* map_bucket(size_t bucket) {
+        size_t bytes = static_cast<size_t>(offsets_[bucket + 1] - offsets_[bucket]);
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offsets_[bucket]);
+        if (p == MAP_FAILED) throw_errno("mmap");
+        return static_cast<T*>(p);
+    }
+
+    void close_file() {
+        if (header_) {
+            ::munmap(header_, alignment_);
+            header_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+public:
+    explicit MappedFileStorage(const std::string& path)
+        : fd_(::open(path.c_str(), O_RDWR | O_CREAT, 0644))
+        , header_(nullptr)
+        , alignment_(static_cast<size_t>(::sysconf(_SC_PAGESIZE))) {
+        if (fd_ < 0) throw_errno("open");
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            close_file();
+            throw_errno("fstat");
+        }
+
+        bool fresh = st.st_size == 0;
+        if (!fresh) {
+            // the header page size was fixed when the file was created
+            FileHeader probe;
+            if (::pread(fd_, &probe, sizeof(probe), 0) != static_cast<ssize_t>(sizeof(probe))
+                || probe.magic_ != MAGIC || probe.version_ != VERSION || probe.elem_size_ != sizeof(T)
+                || probe.alignment_ % alignment_ != 0) {
+                close_file();
+                throw std::runtime_error("persistent vector header mismatch");
+            }
+            alignment_ = probe.alignment_;
+        } else if (::ftruncate(fd_, static_cast<off_t>(alignment_)) != 0) {
+            close_file();
+            throw_errno("ftruncate");
+        }
+
+        void* p = ::mmap(nullptr, alignment_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            close_file();
+            throw_errno("mmap");
+        }
+        header_ = static_cast<FileHeader*>(p);
+        compute_offsets(LockFreeVector<T, MappedFileStorage>::FIRST_BUCKET_SIZE);
+
+        if (fresh) {
+            header_->magic_ = MAGIC;
+            header_->version_ = VERSION;
+            header_->elem_size_ = sizeof(T);
+            header_->alignment_ = alignment_;
+            header_->state_.store(0);
+            header_->synced_state_.store(0);
+            header_->clean_.store(1);
+            ::msync(header_, alignment_, MS_SYNC);
+        }
+    }
+
+    MappedFileStorage(MappedFileStorage&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1))
+        , header_(std::exchange(other.header_, nullptr))
+        , alignment_(other.alignment_) {
+        for (size_t i = 0; i <= MAX_BUCKETS; i++) {
+            offsets_[i] = other.offsets_[i];
+        }
+    }
+
+    MappedFileStorage(const MappedFileStorage&) = delete;
+    MappedFileStorage& operator=(const MappedFileStorage&) = delete;
+    MappedFileStorage& operator=(MappedFileStorage&&) = delete;
+
+    ~MappedFileStorage() {
+        if (header_) {
+            try {
+                sync();
+                header_->clean_.store(1);
+                ::msync(header_, alignment_, MS_SYNC);
+            } catch (...) {}
+        }
+        close_file();
+    }
+
+    T* allocate_bucket(size_t bucket, size_t) {
+        // fallocate only ever grows the file, so racing allocators cannot shrink it under each other
+        int err = ::posix_fallocate(fd_, offsets_[bucket], offsets_[bucket + 1] - offsets_[bucket]);
+        if (err != 0) {
+            errno = err;
+            throw_errno("posix_fallocate");
+        }
+        return map_bucket(bucket);
+    }
+
+    void release_bucket(T* bucket_memory, size_t bucket, size_t) {
+        ::munmap(bucket_memory, static_cast<size_t>(offsets_[bucket + 1] - offsets_[bucket]));
+    }
+
+    void recover(size_t& size, uint32_t& counter, T** buckets) {
+        char boot_id[40];
+        bool same_boot = read_boot_id(boot_id) && std::memcmp(boot_id, header_->boot_id_, sizeof(boot_id)) == 0;
+
+        uint64_t state = header_->clean_.load() || same_boot ? header_->state_.load() : header_->synced_state_.load();
+        header_->state_.store(state);
+        std::memcpy(header_->boot_id_, boot_id, sizeof(boot_id));
+        header_->clean_.store(0);
+        ::msync(header_, alignment_, MS_SYNC);
+
+        size = static_cast<uint32_t>(state);
+        counter = static_cast<uint32_t>(state >> 32);
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) throw_errno("fstat");
+        for (size_t i = 0; i < MAX_BUCKETS && offsets_[i + 1] <= st.st_size; i++) {
+            buckets[i] = map_bucket(i);
+        }
+    }
+
+    // descriptors can complete out of order, only move the header forward
+    void publish(size_t size, uint32_t counter) {
+        uint64_t desired = pack(size, counter);
+        uint64_t current = header_->state_.load(std::memory_order_relaxed);
+        while (static_cast<int32_t>(counter - static_cast<uint32_t>(current >> 32)) > 0) {
+            if (header_->state_.compare_exchange_weak(current, desired, std::memory_order_release)) {
+                return;
+            }
+        }
+    }
+
+    // flushes bucket data first and only then records the state as durable
+    void sync() {
+        uint64_t state = header_->state_.load(std::memory_order_acquire);
+        if (::fdatasync(fd_) != 0) throw_errno("fdatasync");
+        header_->synced_state_.store(state, std::memory_order_release);
+        if (::msync(header_, alignment_, MS_SYNC) != 0) throw_errno("msync");
+    }
+};
+
+template <typename T>
+using PersistentLockFreeVector = LockFreeVector<T, MappedFileStorage<T>>;
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// LockFreeVector variant that lives entirely in a POSIX shared-memory segment so several
+// processes can operate on it at once. every process maps the segment at a different address,
+// so the segment only ever stores offsets from its own start.
+//
+// descriptors come from a fixed pool of slots inside the segment. the descriptor word packs the
+// slot index with the slot's sequence number; a slot's sequence is odd while some operation owns
+// it and is bumped when the slot is retired, so a reader that raced with recycling notices the
+// mismatch and retries. a process that dies mid-operation leaks at most the slot it held, and
+// any write it already published is finished by the next operation that sees it pending.
+//
+// every element is one 64-bit word, the value in the low half and a tag in the high half: the low
+// 32 bits of the counter of the descriptor that last pushed or popped it. a pending write is a cas
+// from the exact word its descriptor saw to value plus its own counter, so it lands at most once;
+// a helper that stalls past a later pop finds a newer tag and fails instead of resurrecting the
+// element. that holds until the counter wraps, 2^32 operations while one helper is stalled
+template <typename T>
+class SharedLockFreeVector {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are shared as raw bytes");
+    static_assert(sizeof(T) <= sizeof(uint32_t), "elements share a 64-bit word with their tag");
+
+private:
+    static constexpr uint32_t MAX_BUCKETS = 32;
+    static constexpr uint32_t FIRST_BUCKET_SIZE = 8;
+    static constexpr uint32_t NUM_SLOTS = 4096;
+    static constexpr uint64_t SEQ_MASK = (1ULL << 48) - 1;
+    static constexpr uint64_t MAGIC = 0x31304d4853564c46ULL; // "FLVSHM01"
+    static constexpr uint32_t VERSION = 2;
+
+    enum InitState : uint32_t { UNINITIALISED = 0, INITIALISING = 1, READY = 2 };
+
+    struct DescriptorSlot {
+        std::atomic<uint64_t> seq_;
+        std::atomic<uint64_t> size_;
+        std::atomic<uint32_t> counter_;
+        std::atomic<bool> has_write_;
+        std::atomic<uint64_t> loc_;     // segment offset of the element the pending write targets
+        std::atomic<uint64_t> old_word_;
+        std::atomic<uint64_t> new_word_;
+    };
+
+    struct SegmentHeader {
+        uint64_t magic_;
+        uint32_t version_;
+        uint32_t elem_size_;
+        std::atomic<uint32_t> init_state_;
+        uint64_t capacity_;
+        uint64_t segment_bytes_;
+        uint64_t slots_offset_;
+        uint64_t bucket_offsets_[MAX_BUCKETS];   // where each bucket would live, 0 past capacity
+        std::atomic<uint64_t> memory_[MAX_BUCKETS];  // installed bucket offsets, 0 = not allocated
+        std::atomic<uint64_t> descriptor_;       // slot index << 48 | slot seq
+        std::atomic<uint64_t> next_slot_;
+    };
+
+    // a validated copy of a descriptor slot
+    struct DescriptorView {
+        uint64_t word_;
+        uint64_t size_;
+        uint32_t counter_;
+        bool has_write_;
+        uint64_t loc_;
+        uint64_t old_word_;
+        uint64_t new_word_;
+    };
+
+    std::string name_;
+    int fd_;
+    char* base_;
+    size_t mapped_bytes_;
+    SegmentHeader* header_;
+    DescriptorSlot* slots_;
+
+    [[noreturn]] static void throw_errno(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    static size_t bucket_size(size_t bucket) { return FIRST_BUCKET_SIZE * (1UL << bucket); }
+
+    static size_t bucket_of(size_t position) {
+        size_t pos = position + FIRST_BUCKET_SIZE;
+        size_t hi_bit = __builtin_clzl(pos) ^ 63;
+        return hi_bit - (__builtin_clz(FIRST_BUCKET_SIZE) ^ 31);
+    }
+
+    static size_t index_of(size_t position) {
+        size_t pos = position + FIRST_BUCKET_SIZE;
+        size_t hi_bit = __builtin_clzl(pos) ^ 63;
+        return pos ^ (1UL << hi_bit);
+    }
+
+    static uint64_t pack(uint64_t slot, uint64_t seq) { return (slot << 48) | (seq & SEQ_MASK); }
+
+    static uint64_t element_word(const T& value, uint32_t tag) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        return (static_cast<uint64_t>(tag) << 32) | bits;
+    }
+
+    static T element_value(uint64_t word) {
+        uint32_t bits = static_cast<uint32_t>(word);
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    std::atomic<uint64_t>& element(uint64_t offset) { return *from_offset<std::atomic<uint64_t>>(offset); }
+
+    template <typename U>
+    U* from_offset(uint64_t offset) const { return reinterpret_cast<U*>(base_ + offset); }
+
+    void initialise(size_t capacity) {
+        header_->magic_ = MAGIC;
+        header_->version_ = VERSION;
+        header_->elem_size_ = sizeof(T);
+        header_->capacity_ = capacity;
+        header_->segment_bytes_ = mapped_bytes_;
+        layout(capacity, header_->bucket_offsets_, &header_->slots_offset_);
+
+        slots_ = from_offset<DescriptorSlot>(header_->slots_offset_);
+        for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+            new (&slots_[i]) DescriptorSlot{};
+        }
+
+        // slot 0 starts out owned as the initial empty descriptor
+        slots_[0].seq_.store(1);
+        header_->descriptor_.store(pack(0, 1));
+        header_->next_slot_.store(1);
+
+        header_->memory_[0].store(header_->bucket_offsets_[0]);
+        for (size_t i = 1; i < MAX_BUCKETS; i++) {
+            header_->memory_[i].store(0);
+        }
+    }
+
+    // segment size for capacity elements, optionally reporting where the slots and buckets go.
+    // the segment is sparse, so untouched buckets cost address space only
+    static uint64_t layout(size_t capacity, uint64_t* bucket_offsets = nullptr, uint64_t* slots_offset = nullptr) {
+        uint64_t offset = (sizeof(SegmentHeader) + 63) / 64 * 64;
+        if (slots_offset) *slots_offset = offset;
+        offset += NUM_SLOTS * sizeof(DescriptorSlot);
+
+        size_t covered = 0;
+        for (size_t i = 0; i < MAX_BUCKETS; i++) {
+            uint64_t bucket_offset = 0;
+            if (covered < capacity || i == 0) {
+                offset = (offset + 63) / 64 * 64;
+                bucket_offset = offset;
+                offset += bucket_size(i) * sizeof(uint64_t);
+                covered += bucket_size(i);
+            }
+            if (bucket_offsets) bucket_offsets[i] = bucket_offset;
+        }
+        return offset;
+    }
+
+    // copies the slot the descriptor word points at, false if the slot was recycled meanwhile
+    bool load_descriptor(DescriptorView& view) {
+        view.word_ = header_->descriptor_.load(std::memory_order_acquire);
+        DescriptorSlot& slot = slots_[view.word_ >> 48];
+
+        view.size_ = slot.size_.load(std::memory_order_relaxed);
+        view.counter_ = slot.counter_.load(std::memory_order_relaxed);
+        view.has_write_ = slot.has_write_.load(std::memory_order_relaxed);
+        view.loc_ = slot.loc_.load(std::memory_order_relaxed);
+        view.old_word_ = slot.old_word_.load(std::memory_order_relaxed);
+        view.new_word_ = slot.new_word_.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (slot.seq_.load(std::memory_order_relaxed) & SEQ_MASK) == (view.word_ & SEQ_MASK);
+    }
+
+    // no completed flag here, a stale helper could flip it on a recycled slot. none is needed:
+    // the tagged cas only succeeds while the element still holds the word the descriptor saw
+    void complete_write(const DescriptorView& view) {
+        if (view.has_write_) {
+            uint64_t expected = view.old_word_;
+            element(view.loc_).compare_exchange_strong(expected, view.new_word_, std::memory_order_acq_rel);
+        }
+    }
+
+    uint32_t claim_slot() {
+        while (true) {
+            uint32_t slot = static_cast<uint32_t>(header_->next_slot_.fetch_add(1, std::memory_order_relaxed) % NUM_SLOTS);
+            uint64_t seq = slots_[slot].seq_.load(std::memory_order_relaxed);
+            if ((seq & 1) == 0 && slots_[slot].seq_.compare_exchange_strong(seq, seq + 1, std::memory_order_acq_rel)) {
+                return slot;
+            }
+        }
+    }
+
+    void retire_slot(uint32_t slot) {
+        slots_[slot].seq_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    uint64_t element_offset(size_t position) {
+        size_t bucket = bucket_of(position);
+        uint64_t offset = header_->memory_[bucket].load(std::memory_order_acquire);
+        if (!offset) {
+            uint64_t expected = 0;
+            header_->memory_[bucket].compare_exchange_strong(expected, header_->bucket_offsets_[bucket]);
+            offset = header_->bucket_offsets_[bucket];
+        }
+        return offset + index_of(position) * sizeof(uint64_t);
+    }
+
+    // installs a new descriptor built from (size, counter, write), retiring whichever slot loses.
+    // the write stores new_val tagged with the new counter over old_word
+    bool try_publish(const DescriptorView& current, uint64_t size, uint64_t loc, uint64_t old_word, const T& new_val) {
+        uint32_t counter = current.counter_ + 1;
+        uint64_t new_word = element_word(new_val, counter);
+        uint32_t slot = claim_slot();
+        DescriptorSlot& mine = slots_[slot];
+        mine.size_.store(size, std::memory_order_relaxed);
+        mine.counter_.store(counter, std::memory_order_relaxed);
+        mine.has_write_.store(true, std::memory_order_relaxed);
+        mine.loc_.store(loc, std::memory_order_relaxed);
+        mine.old_word_.store(old_word, std::memory_order_relaxed);
+        mine.new_word_.store(new_word, std::memory_order_relaxed);
+
+        uint64_t expected = current.word_;
+        uint64_t desired = pack(slot, mine.seq_.load(std::memory_order_relaxed));
+        if (header_->descriptor_.compare_exchange_strong(expected, desired, std::memory_order_acq_rel)) {
+            DescriptorView published{desired, size, counter, true, loc, old_word, new_word};
+            complete_write(published);
+            retire_slot(static_cast<uint32_t>(current.word_ >> 48));
+            return true;
+        }
+
+        retire_slot(slot);
+        return false;
+    }
+
+public:
+    // attaches to the segment called name, creating it sized for capacity elements if it does not
+    // exist yet. capacity is ignored when attaching to an existing segment
+    SharedLockFreeVector(const std::string& name, size_t capacity)
+        : name_(name), fd_(-1), base_(nullptr), mapped_bytes_(0), header_(nullptr), slots_(nullptr) {
+        fd_ = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd_ < 0) throw_errno("shm_open");
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            throw_errno("fstat");
+        }
+
+        mapped_bytes_ = st.st_size > 0 ? static_cast<size_t>(st.st_size) : layout(capacity);
+        if (st.st_size == 0 && ::ftruncate(fd_, static_cast<off_t>(mapped_bytes_)) != 0) {
+            ::close(fd_);
+            throw_errno("ftruncate");
+        }
+
+        void* p = ::mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd_);
+            throw_errno("mmap");
+        }
+        base_ = static_cast<char*>(p);
+        header_ = reinterpret_cast<SegmentHeader*>(base_);
+
+        uint32_t state = UNINITIALISED;
+        if (header_->init_state_.compare_exchange_strong(state, INITIALISING)) {
+            initialise(capacity);
+            header_->init_state_.store(READY, std::memory_order_release);
+        } else {
+            while (header_->init_state_.load(std::memory_order_acquire) != READY) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            if (header_->magic_ != MAGIC || header_->version_ != VERSION || header_->elem_size_ != sizeof(T)
+                || header_->segment_bytes_ != mapped_bytes_) {
+                ::munmap(base_, mapped_bytes_);
+                ::close(fd_);
+                throw std::runtime_error("shared vector segment mismatch");
+            }
+            slots_ = from_offset<DescriptorSlot>(header_->slots_offset_);
+        }
+    }
+
+    SharedLockFreeVector(const SharedLockFreeVector&) = delete;
+    SharedLockFreeVector& operator=(const SharedLockFreeVector&) = delete;
+
+    // detaches this process only, the segment lives on until remove()
+    ~SharedLockFreeVector() {
+        ::munmap(base_, mapped_bytes_);
+        ::close(fd_);
+    }
+
+    static void remove(const std::string& name) { ::shm_unlink(name.c_str()); }
+
+    size_t push_back(const T& elem) {
+        DescriptorView current;
+        while (true) {
+            if (!load_descriptor(current)) continue;
+            complete_write(current);
+
+            if (current.size_ >= header_->capacity_) {
+                throw std::length_error("shared vector capacity exhausted");
+            }
+
+            // stable now: the current descriptor's write has landed and nothing else targets the slot
+            uint64_t loc = element_offset(current.size_);
+            uint64_t old_word = element(loc).load(std::memory_order_acquire);
+            if (try_publish(current, current.size_ + 1, loc, old_word, elem)) {
+                return current.size_;
+            }
+        }
+    }
+
+    T pop_back() {
+        DescriptorView current;
+        while (true) {
+            if (!load_descriptor(current)) continue;
+            complete_write(current);
+
+            if (current.size_ == 0) {
+                throw std::out_of_range("empty");
+            }
+
+            uint64_t loc = element_offset(current.size_ - 1);
+            uint64_t old_word = element(loc).load(std::memory_order_acquire);
+            if (try_publish(current, current.size_ - 1, loc, old_word, T())) {
+                return element_value(old_word);
+            }
+        }
+    }
+
+    // i is checked against capacity rather than size, like LockFreeVector: past capacity there is
+    // no bucket and the offset would land in the segment header
+    T read(size_t i) {
+        if (i >= header_->capacity_) throw std::out_of_range("index past shared vector capacity");
+        return element_value(element(element_offset(i)).load(std::memory_order_acquire));
+    }
+
+    // keeps the element's tag, only pushes and pops advance it
+    void write(size_t i, const T& elem) {
+        if (i >= header_->capacity_) throw std::out_of_range("index past shared vector capacity");
+        std::atomic<uint64_t>& word = element(element_offset(i));
+        uint64_t current = word.load(std::memory_order_relaxed);
+        while (!word.compare_exchange_weak(current, element_word(elem, static_cast<uint32_t>(current >> 32)),
+                                           std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    size_t size() {
+        DescriptorView current;
+        while (!load_descriptor(current)) {}
+        return current.size_;
+    }
+
+    size_t capacity() const { return header_->capacity_; }
+};
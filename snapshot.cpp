@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// on-disk layout shared by LockFreeVector::save/load:
+//   SnapshotHeader | SnapshotBucket[bucket_count] | bucket data...
+// every bucket's data starts at a multiple of alignment_ so it can be mapped in place
+
+static constexpr uint64_t SNAPSHOT_MAGIC = 0x31305350534c4c46ULL; // "FLLSPS01"
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    uint64_t magic_;
+    uint32_t version_;
+    uint32_t elem_size_;
+    uint64_t size_;
+    uint32_t counter_;
+    uint32_t bucket_count_;
+    uint64_t alignment_;
+};
+
+struct SnapshotBucket {
+    uint64_t offset_;     // file offset of the data
+    uint64_t bytes_;      // bytes actually stored, the last bucket is usually partial
+    uint64_t checksum_;
+};
+
+[[noreturn]] inline void throw_snapshot_errno(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// fletcher-style sum over 64-bit words, one add chain per word keeps it near memory bandwidth
+inline uint64_t snapshot_checksum(const void* data, size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t a = 0, b = 0;
+    size_t words = bytes / sizeof(uint64_t);
+    for (size_t i = 0; i < words; i++) {
+        uint64_t w;
+        std::memcpy(&w, p + i * sizeof(uint64_t), sizeof(w));
+        a += w;
+        b += a;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + words * sizeof(uint64_t), bytes % sizeof(uint64_t));
+    a += tail;
+    b += a;
+    return a ^ (b << 1) ^ bytes;
+}
+
+// pwritev until every iovec is on disk, iov is consumed in the process
+inline void snapshot_pwritev(int fd, std::vector<iovec>& iov, off_t offset) {
+    size_t first = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t n = ::pwritev(fd, iov.data() + first, count, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw_snapshot_errno("pwritev");
+        }
+        offset += n;
+        size_t left = static_cast<size_t>(n);
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            first++;
+        }
+        if (left > 0) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+}
+
+// writes iov to path + ".tmp", syncs it and renames it over path, so path holds either the old or
+// the new contents after a crash. a previous file at path that is still mapped keeps its pages
+inline void snapshot_replace_file(const std::string& path, std::vector<iovec>& iov) {
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw_snapshot_errno("open");
+    try {
+        snapshot_pwritev(fd, iov, 0);
+        if (::fsync(fd) != 0) throw_snapshot_errno("fsync");
+    } catch (...) {
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        throw;
+    }
+    ::close(fd);
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        int error = errno;
+        ::unlink(tmp.c_str());
+        errno = error;
+        throw_snapshot_errno("rename");
+    }
+
+    // the rename itself is only durable once the directory is
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    int dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) throw_snapshot_errno("open");
+    int synced = ::fsync(dir_fd);
+    ::close(dir_fd);
+    if (synced != 0) throw_snapshot_errno("fsync");
+}
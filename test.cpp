@@ -4,6 +4,18 @@
 #include <random>
 #include <chrono>
 #include "lock-free-vector.cpp"
+#include "lock-free-queue.cpp"
+#include "durable-log.cpp"
+#include "persistent-vector.cpp"
+#include "shared-vector.cpp"
+#include "columnar-vector.cpp"
+#include "allocator-storage.cpp"
+#include "op-trace.cpp"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
 
 class LockFreeVectorTest : public ::testing::Test {
 protected:
@@ -107,4 +119,727 @@ TEST_F(LockFreeVectorTest, ConcurrentMixedOperations) {
     }
 
     ASSERT_EQ(vec->size(), total_pushes - total_pops);
-}
\ No newline at end of file
+}
+
+TEST(LockFreeQueueTest, FifoOrderSequential) {
+    LockFreeQueue<int> queue;
+    for (int i = 0; i < 1000; i++) {
+        queue.enqueue(i);
+    }
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(queue.dequeue(), i);
+    }
+    int value;
+    ASSERT_FALSE(queue.try_dequeue(value));
+}
+
+TEST(LockFreeQueueTest, ConcurrentProducersConsumers) {
+    const int num_producers = 4;
+    const int num_consumers = 4;
+    const int items_per_producer = 20000;
+    LockFreeQueue<int> queue;
+    std::atomic<long long> consumed_sum(0);
+    std::atomic<int> consumed_count(0);
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < num_producers; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < items_per_producer; i++) {
+                queue.enqueue(p * items_per_producer + i);
+            }
+        });
+    }
+    for (int c = 0; c < num_consumers; c++) {
+        threads.emplace_back([&]() {
+            // values from one producer must come out in the order they went in
+            std::vector<int> last_seen(num_producers, -1);
+            int value;
+            while (consumed_count.load() < num_producers * items_per_producer) {
+                if (queue.try_dequeue(value)) {
+                    int producer = value / items_per_producer;
+                    ASSERT_GT(value, last_seen[producer]);
+                    last_seen[producer] = value;
+                    consumed_sum += value;
+                    consumed_count++;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    long long total = num_producers * items_per_producer;
+    ASSERT_EQ(consumed_count.load(), total);
+    ASSERT_EQ(consumed_sum.load(), total * (total - 1) / 2);
+}
+
+TEST(DurableLogTest, ConcurrentAppendsSurviveReopen) {
+    const int num_threads = 4;
+    const int appends_per_thread = 200;
+    std::string path = (std::filesystem::temp_directory_path() / "durable_log_test.wal").string();
+    std::filesystem::remove(path);
+
+    {
+        DurableLog<int> log(path, 16);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&log, t]() {
+                for (int i = 0; i < appends_per_thread; i++) {
+                    size_t index = log.push_back(t * appends_per_thread + i);
+                    ASSERT_GT(log.durable_size(), index);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(log.durable_size(), num_threads * appends_per_thread);
+    }
+
+    DurableLog<int> reopened(path);
+    ASSERT_EQ(reopened.size(), num_threads * appends_per_thread);
+    std::vector<int> seen;
+    for (size_t i = 0; i < reopened.size(); i++) {
+        seen.push_back(reopened.read(i));
+    }
+    std::sort(seen.begin(), seen.end());
+    for (int i = 0; i < num_threads * appends_per_thread; i++) {
+        ASSERT_EQ(seen[i], i);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(DurableLogTest, FailedFlushFailsTheLog) {
+    std::string path = (std::filesystem::temp_directory_path() / "durable_log_failure_test.wal").string();
+    std::filesystem::remove(path);
+
+    // a file size limit makes the pwrite that crosses it fail with EFBIG
+    rlimit saved;
+    ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &saved), 0);
+    auto saved_handler = std::signal(SIGXFSZ, SIG_IGN);
+    rlimit limited = saved;
+    limited.rlim_cur = 4096;
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+
+    size_t durable = 0;
+    {
+        DurableLog<int> log(path, 16);
+        size_t failed_at = 0;
+        for (int i = 0; ; i++) {
+            try {
+                log.push_back(i);
+            } catch (const std::system_error&) {
+                failed_at = static_cast<size_t>(i);
+                break;
+            }
+        }
+        ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &saved), 0);
+
+        // nothing from the failed batch is acknowledged, later appends and waits fail too
+        durable = log.durable_size();
+        ASSERT_LE(durable, failed_at);
+        ASSERT_THROW(log.push_back(-1), std::system_error);
+        ASSERT_THROW(log.sync(), std::system_error);
+        ASSERT_EQ(log.durable_size(), durable);
+    }
+    std::signal(SIGXFSZ, saved_handler);
+
+    DurableLog<int> reopened(path);
+    ASSERT_GE(reopened.size(), durable);
+    for (size_t i = 0; i < durable; i++) {
+        ASSERT_EQ(reopened.read(i), static_cast<int>(i));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(PersistentVectorTest, ReopenRestoresContents) {
+    std::string path = (std::filesystem::temp_directory_path() / "persistent_vector_test.lfv").string();
+    std::filesystem::remove(path);
+
+    {
+        PersistentLockFreeVector<int> vec{MappedFileStorage<int>(path)};
+        for (int i = 0; i < 1000; i++) {
+            vec.push_back(i);
+        }
+        for (int i = 0; i < 10; i++) {
+            vec.pop_back();
+        }
+    }
+
+    {
+        PersistentLockFreeVector<int> vec{MappedFileStorage<int>(path)};
+        ASSERT_EQ(vec.size(), 990);
+        for (size_t i = 0; i < vec.size(); i++) {
+            ASSERT_EQ(vec.read(i), static_cast<int>(i));
+        }
+        vec.push_back(-1);
+    }
+
+    PersistentLockFreeVector<int> vec{MappedFileStorage<int>(path)};
+    ASSERT_EQ(vec.size(), 991);
+    ASSERT_EQ(vec.read(990), -1);
+    std::filesystem::remove(path);
+}
+
+TEST(SnapshotTest, SaveLoadRoundTrip) {
+    std::string path = (std::filesystem::temp_directory_path() / "snapshot_test.lfvs").string();
+    LockFreeVector<int> source;
+    for (int i = 0; i < 5000; i++) {
+        source.push_back(i * 3);
+    }
+    source.save(path);
+
+    LockFreeVector<int> restored;
+    restored.push_back(42);
+    restored.load(path);
+    ASSERT_EQ(restored.size(), 5000);
+    for (size_t i = 0; i < restored.size(); i++) {
+        ASSERT_EQ(restored.read(i), static_cast<int>(i) * 3);
+    }
+
+    // the partially filled last bucket must stay writable past the stored bytes
+    for (int i = 0; i < 5000; i++) {
+        restored.push_back(-i);
+    }
+    ASSERT_EQ(restored.read(9999), -4999);
+    ASSERT_EQ(restored.pop_back(), -4999);
+    std::filesystem::remove(path);
+}
+
+TEST(SnapshotTest, SaveOverLoadedFile) {
+    std::string path = (std::filesystem::temp_directory_path() / "snapshot_resave_test.lfvs").string();
+    LockFreeVector<int> source;
+    for (int i = 0; i < 3000; i++) {
+        source.push_back(i);
+    }
+    source.save(path);
+
+    // the buckets are mappings of path, saving over it must not pull the pages out from under them
+    LockFreeVector<int> restored;
+    restored.load(path);
+    restored.write(7, -7);
+    restored.push_back(3000);
+    restored.save(path);
+    for (int i = 0; i < 3000; i++) {
+        ASSERT_EQ(restored.read(i), i == 7 ? -7 : i);
+    }
+
+    LockFreeVector<int> reloaded;
+    reloaded.load(path);
+    ASSERT_EQ(reloaded.size(), 3001);
+    ASSERT_EQ(reloaded.read(7), -7);
+    ASSERT_EQ(reloaded.read(2999), 2999);
+    ASSERT_EQ(reloaded.read(3000), 3000);
+    ASSERT_FALSE(std::filesystem::exists(path + ".tmp"));
+    std::filesystem::remove(path);
+}
+
+TEST(SnapshotTest, LoadRejectsCorruptBucket) {
+    std::string path = (std::filesystem::temp_directory_path() / "snapshot_corrupt_test.lfvs").string();
+    LockFreeVector<int> source;
+    for (int i = 0; i < 100; i++) {
+        source.push_back(i);
+    }
+    source.save(path);
+
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-4, std::ios::end);
+        int garbage = -1;
+        file.write(reinterpret_cast<const char*>(&garbage), sizeof(garbage));
+    }
+
+    LockFreeVector<int> restored;
+    ASSERT_THROW(restored.load(path), std::runtime_error);
+    ASSERT_EQ(restored.size(), 0);
+    std::filesystem::remove(path);
+}
+
+TEST(SnapshotTest, IncrementalCheckpointChain) {
+    std::string manifest = (std::filesystem::temp_directory_path() / "checkpoint_test.manifest").string();
+    LockFreeVector<int> source;
+    for (int i = 0; i < 10000; i++) {
+        source.push_back(i);
+    }
+    std::string base = source.checkpoint(manifest, true);
+
+    source.write(3, -3);
+    source.push_back(10000);
+    std::string delta = source.checkpoint(manifest);
+    // bucket 0 and the tail bucket only
+    ASSERT_LT(std::filesystem::file_size(delta), std::filesystem::file_size(base) / 4);
+
+    source.pop_back();
+    source.pop_back();
+    source.checkpoint(manifest);
+
+    LockFreeVector<int> restored;
+    restored.restore(manifest);
+    ASSERT_EQ(restored.size(), source.size());
+    for (size_t i = 0; i < source.size(); i++) {
+        ASSERT_EQ(restored.read(i), source.read(i));
+    }
+
+    // a new chain from the restored vector, whose buckets are mapped from the old chain's files
+    restored.write(5, -5);
+    std::string rebased = restored.checkpoint(manifest, true);
+    ASSERT_NE(rebased, base);
+    ASSERT_FALSE(std::filesystem::exists(base));
+    ASSERT_EQ(restored.read(9000), 9000);
+
+    LockFreeVector<int> rebased_restore;
+    rebased_restore.restore(manifest);
+    ASSERT_EQ(rebased_restore.size(), source.size());
+    ASSERT_EQ(rebased_restore.read(3), -3);
+    ASSERT_EQ(rebased_restore.read(5), -5);
+    ASSERT_EQ(rebased_restore.read(9000), 9000);
+
+    std::filesystem::remove(rebased);
+    std::filesystem::remove(manifest);
+}
+
+TEST(SharedVectorTest, ProcessesShareOneVector) {
+    const std::string name = "/lfv_shared_test_" + std::to_string(::getpid());
+    const int per_process = 5000;
+    SharedLockFreeVector<int>::remove(name);
+
+    SharedLockFreeVector<int> vec(name, 1 << 16);
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // separate mapping, separate address
+        SharedLockFreeVector<int> attached(name, 0);
+        for (int i = 0; i < per_process; i++) {
+            attached.push_back(per_process + i);
+        }
+        ::_exit(0);
+    }
+
+    for (int i = 0; i < per_process; i++) {
+        vec.push_back(i);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    ASSERT_EQ(vec.size(), 2 * per_process);
+    std::vector<int> seen;
+    for (size_t i = 0; i < vec.size(); i++) {
+        seen.push_back(vec.read(i));
+    }
+    std::sort(seen.begin(), seen.end());
+    for (int i = 0; i < 2 * per_process; i++) {
+        ASSERT_EQ(seen[i], i);
+    }
+    int last = vec.read(vec.size() - 1);
+    ASSERT_EQ(vec.pop_back(), last);
+
+    ASSERT_THROW(vec.write(vec.capacity(), 1), std::out_of_range);
+    ASSERT_THROW(vec.read(vec.capacity() + 100), std::out_of_range);
+    ASSERT_EQ(vec.size(), 2 * per_process - 1);
+    SharedLockFreeVector<int>::remove(name);
+}
+
+TEST(FrozenBucketTest, FreezeReadAndThaw) {
+    LockFreeVector<int64_t> vec;
+    int64_t timestamp = -5000000;
+    std::vector<int64_t> expected;
+    for (int i = 0; i < 20000; i++) {
+        timestamp += 1000 + (i * 7919) % 300;
+        vec.push_back(timestamp);
+        expected.push_back(timestamp);
+    }
+
+    ASSERT_GT(vec.freeze_cold_buckets(1), 0);
+    ASSERT_GT(vec.frozen_bytes(), 0);
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(vec.read(i), expected[i]);
+    }
+
+    // writing into a frozen bucket thaws it with every other element intact
+    vec.write(100, -1);
+    expected[100] = -1;
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(vec.read(i), expected[i]);
+    }
+    vec.collect_retired();
+}
+
+TEST(FrozenBucketTest, WritesDuringFreezeAreKept) {
+    LockFreeVector<int64_t> vec;
+    for (int i = 0; i < 50000; i++) {
+        vec.push_back(0);
+    }
+
+    std::atomic<bool> done{false};
+    std::thread freezer([&]() {
+        while (!done.load()) {
+            vec.freeze_cold_buckets(1);
+        }
+    });
+    for (int64_t round = 1; round <= 4; round++) {
+        for (int i = 0; i < 50000; i++) {
+            vec.write(i, round * i);
+        }
+    }
+    done.store(true);
+    freezer.join();
+
+    for (int i = 0; i < 50000; i++) {
+        ASSERT_EQ(vec.read(i), 4 * i);
+    }
+    vec.collect_retired();
+}
+
+TEST(TieredStorageTest, SpillAndFaultBack) {
+    LockFreeVector<int> vec;
+    vec.enable_tiering("/tmp/lfv_test_tier", 64 * 1024);
+    for (int i = 0; i < 100000; i++) {
+        vec.push_back(i * 3);
+    }
+
+    ASSERT_GT(vec.enforce_memory_budget(), 0);
+    // only the partially filled last bucket (8 << 13 elements) may exceed the budget
+    ASSERT_LE(vec.resident_bytes(), 64 * 1024 + (8 << 13) * sizeof(int));
+    vec.collect_retired();
+
+    // spilled buckets are faulted back on first touch and keep every element
+    for (int i = 0; i < 100000; i++) {
+        ASSERT_EQ(vec.read(i), i * 3);
+    }
+    vec.enforce_memory_budget();
+    vec.write(5, -1);
+    ASSERT_EQ(vec.read(5), -1);
+    ASSERT_EQ(vec.read(6), 18);
+    vec.collect_retired();
+}
+
+TEST(TieredStorageTest, WritesDuringEvictionAreKept) {
+    LockFreeVector<int> vec;
+    vec.enable_tiering("/tmp/lfv_test_tier_concurrent", 16 * 1024);
+    for (int i = 0; i < 50000; i++) {
+        vec.push_back(0);
+    }
+
+    std::atomic<bool> done{false};
+    std::thread evictor([&]() {
+        while (!done.load()) {
+            vec.enforce_memory_budget();
+        }
+    });
+    for (int round = 1; round <= 4; round++) {
+        for (int i = 0; i < 50000; i++) {
+            vec.write(i, round);
+        }
+    }
+    done.store(true);
+    evictor.join();
+
+    for (int i = 0; i < 50000; i++) {
+        ASSERT_EQ(vec.read(i), 4);
+    }
+    vec.collect_retired();
+}
+
+TEST(ColumnarVectorTest, ConcurrentRecordsStayAligned) {
+    ColumnarLockFreeVector<int64_t, double, int32_t> vec;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&vec, t]() {
+            for (int i = 0; i < 10000; i++) {
+                vec.push_back(i, i * 0.5, t);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    ASSERT_EQ(vec.size(), 40000);
+
+    // every column of a record was written by the same push
+    for (size_t i = 0; i < vec.size(); i++) {
+        auto [id, half, thread] = vec.read(i);
+        ASSERT_EQ(half, id * 0.5);
+        ASSERT_GE(thread, 0);
+        ASSERT_LT(thread, 4);
+    }
+
+    int64_t sum = 0;
+    vec.scan<0>(0, vec.size(), [&sum](const int64_t* data, size_t count) {
+        for (size_t i = 0; i < count; i++) sum += data[i];
+    });
+    ASSERT_EQ(sum, 4LL * 9999 * 10000 / 2);
+
+    vec.write<2>(0, 42);
+    ASSERT_EQ(vec.read<2>(0), 42);
+    auto last = vec.read(vec.size() - 1);
+    ASSERT_EQ(vec.pop_back(), last);
+    ASSERT_EQ(vec.size(), 39999);
+}
+
+TEST(AllocatorStorageTest, PmrBucketsAndDescriptors) {
+    // counts descriptor traffic so the test can tell it was routed away from global new
+    struct CountingResource : std::pmr::memory_resource {
+        size_t allocations_ = 0;
+        size_t bytes_ = 0;
+        void* do_allocate(size_t bytes, size_t align) override {
+            allocations_++;
+            bytes_ += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::pmr::unsynchronized_pool_resource arena;
+    CountingResource descriptors;
+    {
+        PmrLockFreeVector<int, 64> vec(PmrStorage<int, 64>(&arena, &descriptors));
+        for (int i = 0; i < 1000; i++) {
+            vec.push_back(i);
+        }
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_EQ(vec.read(i), i);
+        }
+        // bucket k starts at position (8 << k) - 8
+        for (size_t k = 0; (8UL << k) - 8 < 1000; k++) {
+            ASSERT_EQ(reinterpret_cast<uintptr_t>(&vec.at((8UL << k) - 8)) % 64, 0);
+        }
+        ASSERT_EQ(vec.pop_back(), 999);
+        ASSERT_GE(descriptors.allocations_, 2 * 1001);
+    }
+
+    // huge-page sized alignment on the default allocator
+    LockFreeVector<int, AllocatorStorage<int, std::allocator<int>, 2 * 1024 * 1024>> huge;
+    huge.push_back(1);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(&huge.at(0)) % (2 * 1024 * 1024), 0);
+
+    // aligned buckets cost their own size, not a whole 2 MiB block each
+    CountingResource buckets;
+    {
+        PmrLockFreeVector<int, 2 * 1024 * 1024> vec{PmrStorage<int, 2 * 1024 * 1024>(&buckets)};
+        for (int i = 0; i < 100; i++) {
+            vec.push_back(i);
+        }
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(&vec.at(56)) % (2 * 1024 * 1024), 0);
+        ASSERT_EQ(buckets.bytes_, (8 + 16 + 32 + 64) * sizeof(int));
+    }
+}
+
+#ifdef LFV_STATS
+TEST(VectorStatsTest, CountsContention) {
+    LockFreeVector<int> vec;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&vec]() {
+            for (int i = 0; i < 10000; i++) {
+                vec.push_back(i);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    vec.pop_back();
+
+    VectorStats stats = vec.stats();
+    ASSERT_EQ(stats.operations_, 40001);
+    ASSERT_EQ(stats.descriptor_cas_attempts_ - stats.descriptor_cas_failures_, 40001);
+    ASSERT_EQ(stats.retries_, stats.descriptor_cas_failures_);
+    ASSERT_GE(stats.descriptor_allocations_, 2 * stats.descriptor_cas_attempts_);
+    // 40000 elements span buckets 0..12, the constructor allocates bucket 0
+    ASSERT_EQ(stats.bucket_allocations_ - stats.bucket_allocation_races_, 12);
+}
+#endif
+
+TEST(LatencyHistogramTest, PercentilesAndMerge) {
+    LatencyHistogram a, b;
+    for (uint64_t v = 1; v <= 10000; v++) {
+        a.record(v);
+    }
+    b.record(5000000);
+    a.merge(b);
+
+    ASSERT_EQ(a.count(), 10001);
+    ASSERT_EQ(a.max(), 5000000);
+    // log-linear buckets keep every answer within 1/32 of the exact value
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        double exact = p / 100.0 * 10001;
+        ASSERT_NEAR(static_cast<double>(a.percentile(p)), exact, exact / 32 + 1);
+    }
+    ASSERT_EQ(a.percentile(100), 5000000);
+    ASSERT_LE(a.percentile(0), 1);
+}
+
+#ifdef LFV_LATENCY
+TEST(LatencyHistogramTest, VectorRecordsEveryOperation) {
+    LockFreeVector<int> vec;
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+        vec.read(i);
+    }
+    vec.write(0, 1);
+    vec.pop_back();
+
+    LatencyHistogram push, read, write, pop;
+    vec.latency(VectorOp::PUSH_BACK, push);
+    vec.latency(VectorOp::READ, read);
+    vec.latency(VectorOp::WRITE, write);
+    vec.latency(VectorOp::POP_BACK, pop);
+    ASSERT_EQ(push.count(), 1000);
+    ASSERT_EQ(read.count(), 1000);
+    ASSERT_EQ(write.count(), 1);
+    ASSERT_EQ(pop.count(), 1);
+    ASSERT_GT(push.percentile(99.99), 0);
+}
+
+TEST(LatencyHistogramTest, FirstOperationSkipsCalibration) {
+    LockFreeVector<int> vec;
+    // the clock is calibrated over 10ms when the recorder is built, not inside an operation
+    auto start = std::chrono::steady_clock::now();
+    vec.push_back(1);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+}
+#endif
+
+#ifdef LFV_TRACE
+TEST(FlightRecorderTest, DumpHoldsRecentOperations) {
+    LockFreeVector<int> vec;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([&vec]() {
+            for (int i = 0; i < 100; i++) {
+                vec.push_back(i);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    const std::string path = "/tmp/lfv_test_trace.bin";
+    FlightRecorder::dump(path);
+
+    std::ifstream in(path, std::ios::binary);
+    TraceFileHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    ASSERT_EQ(header.magic_, TRACE_MAGIC);
+    ASSERT_GE(header.ring_count_, 2);
+
+    size_t pushes = 0, allocations = 0;
+    std::vector<TraceEvent> ring(header.ring_size_);
+    for (uint32_t r = 0; r < header.ring_count_; r++) {
+        TraceRingHeader ring_header;
+        in.read(reinterpret_cast<char*>(&ring_header), sizeof(ring_header));
+        in.read(reinterpret_cast<char*>(ring.data()), ring.size() * sizeof(TraceEvent));
+        for (uint64_t i = 0; i < std::min<uint64_t>(ring_header.head_, ring.size()); i++) {
+            pushes += ring[i].op_ == static_cast<uint8_t>(TraceOp::PUSH_BACK) && ring[i].index_ < 200;
+            allocations += ring[i].op_ == static_cast<uint8_t>(TraceOp::BUCKET_ALLOCATION);
+        }
+    }
+    ASSERT_TRUE(in.good());
+    // other tests in this binary may have left events behind, so only a lower bound is exact
+    ASSERT_GE(pushes, 200);
+    ASSERT_GE(allocations, 4);
+    std::filesystem::remove(path);
+}
+#endif
+
+TEST(LiveStatsTest, ExportedVectorIsVisibleInSegment) {
+    LockFreeVector<int> vec;
+    for (int i = 0; i < 100; i++) {
+        vec.push_back(i);
+    }
+    vec.export_live_stats("live_stats_test");
+
+    int fd = shm_open(live_stats_segment_name(getpid()).c_str(), O_RDONLY, 0);
+    ASSERT_GE(fd, 0);
+    void* p = mmap(nullptr, sizeof(LiveStatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(p, MAP_FAILED);
+    const LiveStatsSegment* segment = static_cast<const LiveStatsSegment*>(p);
+    ASSERT_EQ(segment->magic_, LIVE_STATS_MAGIC);
+
+    // wait for the sampler thread to publish a sample
+    bool found = false;
+    for (int attempt = 0; attempt < 100 && !found; attempt++) {
+        for (const LiveStatsSlot& slot : segment->slots_) {
+            LiveStatsSample sample;
+            if (read_live_stats(slot, sample) && std::string(sample.name_) == "live_stats_test" && sample.size_ == 100) {
+                ASSERT_EQ(sample.capacity_, 120);
+                ASSERT_EQ(sample.buckets_, 4);
+                found = true;
+            }
+        }
+        if (!found) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(found);
+    munmap(p, sizeof(LiveStatsSegment));
+
+    // a writer that died mid-update leaves the sequence odd, readers give up instead of spinning
+    LiveStatsSlot stuck{};
+    stuck.in_use_.store(1);
+    stuck.seq_.store(7);
+    LiveStatsSample sample;
+    ASSERT_FALSE(read_live_stats(stuck, sample));
+}
+
+TEST(MemoryStatsTest, AccountsBucketsSlackAndDescriptors) {
+    LockFreeVector<int64_t> vec;
+    for (int i = 0; i < 100; i++) {
+        vec.push_back(i);
+    }
+    vec.pop_back();
+
+    // 99 elements fill buckets 0..2 (56 slots) and 43 of bucket 3's 64
+    MemoryStats stats = vec.memory_stats();
+    ASSERT_EQ(stats.live_bytes_, 99 * sizeof(int64_t));
+    ASSERT_EQ(stats.bucket_bytes_, 120 * sizeof(int64_t));
+    ASSERT_EQ(stats.slack_bytes_, 21 * sizeof(int64_t));
+    ASSERT_EQ(stats.buckets_[3].state_, BucketState::RAW);
+    ASSERT_EQ(stats.buckets_[3].used_, 43);
+    ASSERT_EQ(stats.buckets_[4].state_, BucketState::EMPTY);
+    // the initial descriptor plus one per push and pop
+    ASSERT_EQ(stats.descriptors_, 102);
+
+    vec.freeze_bucket(2);
+    stats = vec.memory_stats();
+    ASSERT_EQ(stats.buckets_[2].state_, BucketState::FROZEN);
+    ASSERT_EQ(stats.frozen_bytes_, stats.buckets_[2].resident_bytes_);
+    ASSERT_EQ(stats.retired_bytes_, 32 * sizeof(int64_t));
+    vec.collect_retired();
+    ASSERT_EQ(vec.memory_stats().retired_bytes_, 0);
+}
+
+TEST(OpTraceTest, RecordedStreamsRoundTrip) {
+    std::string path = (std::filesystem::temp_directory_path() / "lfv_op_trace_test.bin").string();
+    RecordingVector<int64_t> vec;
+    for (int64_t i = 0; i < 100; ++i) vec.push_back(-i);
+
+    std::thread other([&vec]() {
+        vec.write(5, 1LL << 40);
+        vec.read(99);
+        vec.pop_back();
+    });
+    other.join();
+    ASSERT_EQ(vec.size(), 99);
+    vec.save_trace(path);
+
+    OpTrace trace = load_op_trace(path);
+    std::filesystem::remove(path);
+    ASSERT_EQ(trace.streams_.size(), 2);
+    ASSERT_EQ(trace.ops(), 104);
+
+    const auto& main_ops = trace.streams_[0];
+    ASSERT_EQ(main_ops.size(), 101);
+    ASSERT_EQ(main_ops[42].op_, TracedOpKind::PUSH_BACK);
+    ASSERT_EQ(main_ops[42].value_, -42);
+    ASSERT_EQ(main_ops[100].op_, TracedOpKind::SIZE);
+
+    const auto& other_ops = trace.streams_[1];
+    ASSERT_EQ(other_ops.size(), 3);
+    ASSERT_EQ(other_ops[0].op_, TracedOpKind::WRITE);
+    ASSERT_EQ(other_ops[0].index_, 5);
+    ASSERT_EQ(other_ops[0].value_, 1LL << 40);
+    ASSERT_EQ(other_ops[1].op_, TracedOpKind::READ);
+    ASSERT_EQ(other_ops[1].index_, 99);
+    ASSERT_EQ(other_ops[2].op_, TracedOpKind::POP_BACK);
+}
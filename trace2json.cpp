@@ -0,0 +1,90 @@
+// converts a FlightRecorder dump into Chrome trace JSON, which chrome://tracing and
+// ui.perfetto.dev both open. usage: lfv_trace2json <dump> [out.json]
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "flight-recorder.cpp"
+
+static const char* op_name(uint8_t op) {
+    switch (static_cast<TraceOp>(op)) {
+        case TraceOp::PUSH_BACK: return "push_back";
+        case TraceOp::POP_BACK: return "pop_back";
+        case TraceOp::WRITE: return "write";
+        case TraceOp::BUCKET_ALLOCATION: return "bucket_allocation";
+        case TraceOp::BUCKET_ALLOCATION_RACE: return "bucket_allocation_race";
+    }
+    return "unknown";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <dump> [out.json]\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    TraceFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic_ != TRACE_MAGIC
+        || header.version_ != TRACE_VERSION) {
+        std::cerr << argv[1] << ": not a trace dump\n";
+        return 1;
+    }
+
+    struct Event {
+        TraceEvent event_;
+        uint32_t thread_id_;
+    };
+    std::vector<Event> events;
+    std::vector<uint32_t> threads;
+    std::vector<TraceEvent> ring(header.ring_size_);
+    for (uint32_t r = 0; r < header.ring_count_; r++) {
+        TraceRingHeader ring_header;
+        if (!in.read(reinterpret_cast<char*>(&ring_header), sizeof(ring_header))
+            || !in.read(reinterpret_cast<char*>(ring.data()), ring.size() * sizeof(TraceEvent))) {
+            std::cerr << argv[1] << ": truncated\n";
+            return 1;
+        }
+        threads.push_back(ring_header.thread_id_);
+        uint64_t count = std::min<uint64_t>(ring_header.head_, header.ring_size_);
+        for (uint64_t i = ring_header.head_ - count; i < ring_header.head_; i++) {
+            events.push_back({ring[i % header.ring_size_], ring_header.thread_id_});
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.event_.start_ < b.event_.start_;
+    });
+
+    std::ofstream file;
+    if (argc > 2) file.open(argv[2]);
+    std::ostream& out = argc > 2 ? file : std::cout;
+
+    // chrome trace timestamps are microseconds, relative to the oldest event
+    uint64_t origin = events.empty() ? 0 : events.front().event_.start_;
+    auto micros = [&](uint64_t ticks) { return static_cast<double>(ticks) * header.ns_per_tick_ / 1000.0; };
+
+    out << std::fixed;
+    out.precision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for (uint32_t thread : threads) {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << header.pid_
+            << ",\"tid\":" << thread << ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+        first = false;
+    }
+    for (const Event& e : events) {
+        const TraceEvent& event = e.event_;
+        bool instant = static_cast<TraceOp>(event.op_) == TraceOp::BUCKET_ALLOCATION
+                       || static_cast<TraceOp>(event.op_) == TraceOp::BUCKET_ALLOCATION_RACE;
+        out << (first ? "" : ",\n") << "{\"name\":\"" << op_name(event.op_) << "\",\"cat\":\"vector\",\"ph\":\""
+            << (instant ? "i\",\"s\":\"t" : "X") << "\",\"ts\":" << micros(event.start_ - origin);
+        if (!instant) out << ",\"dur\":" << micros(event.duration_);
+        out << ",\"pid\":" << header.pid_ << ",\"tid\":" << e.thread_id_ << ",\"args\":{\""
+            << (instant ? "bucket" : "index") << "\":" << event.index_ << ",\"retries\":" << event.retries_ << "}}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return out ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// USDT tracepoints under the provider "lfv", for bpftrace / perf / systemtap. a probe site is a
+// single nop plus a note in the ELF file, it only costs something while a tracer is attached.
+// probes are compiled in with LFV_USDT when <sys/sdt.h> (systemtap-sdt-dev) is available:
+//
+//   push_entry()                       push_return(index, retries)
+//   pop_entry()                        pop_return(index, retries)
+//   cas_fail(op, retries)              op is 0 for push_back, 1 for pop_back
+//   help(location)                     a pending write finished on another thread's behalf
+//   bucket_alloc_entry(bucket)         bucket_alloc_return(bucket, status)
+//                                      status is 1 installed, 0 lost the race, 2 already present
+//
+// see bpftrace/ for example scripts
+
+#if defined(LFV_USDT) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LFV_PROBE0(name) STAP_PROBE(lfv, name)
+#define LFV_PROBE1(name, a) STAP_PROBE1(lfv, name, a)
+#define LFV_PROBE2(name, a, b) STAP_PROBE2(lfv, name, a, b)
+#else
+#define LFV_PROBE0(name) ((void)0)
+#define LFV_PROBE1(name, a) ((void)0)
+#define LFV_PROBE2(name, a, b) ((void)0)
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// contention and progress counters, aggregated on demand by LockFreeVector::stats()
+struct VectorStats {
+    uint64_t operations_ = 0;                 // push_back + pop_back calls that completed
+    uint64_t retries_ = 0;                    // extra loop iterations those calls needed
+    uint64_t max_retries_ = 0;                // worst single call
+    uint64_t reads_ = 0;
+    uint64_t writes_ = 0;
+    uint64_t descriptor_cas_attempts_ = 0;
+    uint64_t descriptor_cas_failures_ = 0;
+    uint64_t helped_writes_ = 0;              // pending writes finished on behalf of another thread
+    uint64_t bucket_allocations_ = 0;
+    uint64_t bucket_allocation_races_ = 0;    // allocations thrown away because another thread won
+    uint64_t descriptor_allocations_ = 0;
+};
+
+// where one bucket's memory currently is
+enum class BucketState { EMPTY, RAW, MAPPED, FROZEN, SPILLED };
+
+struct BucketMemoryStats {
+    BucketState state_ = BucketState::EMPTY;
+    size_t capacity_ = 0;        // elements
+    size_t used_ = 0;            // elements below size()
+    size_t resident_bytes_ = 0;  // raw, mapped or compressed bytes held in memory
+};
+
+// memory accounting returned by LockFreeVector::memory_stats()
+struct MemoryStats {
+    size_t bucket_bytes_ = 0;         // raw and mapped buckets
+    size_t frozen_bytes_ = 0;         // compressed buckets
+    size_t spilled_bytes_ = 0;        // buckets currently in the tier file
+    size_t live_bytes_ = 0;           // size() * sizeof(T)
+    size_t slack_bytes_ = 0;          // allocated raw slots past size(), mostly the last bucket's tail
+    size_t retired_bytes_ = 0;        // replaced buckets waiting for collect_retired()
+    size_t descriptors_ = 0;          // descriptors allocated and never reclaimed
+    size_t descriptor_bytes_ = 0;     // including their write descriptors
+    BucketMemoryStats buckets_[32];
+};
+
+// the counters behind VectorStats, sharded so that each thread normally bumps counters on its own
+// cache line. threads are spread round robin over the shards, beyond SHARDS threads they share
+class StatsCounters {
+public:
+    enum Counter {
+        OPERATIONS,
+        RETRIES,
+        READS,
+        WRITES,
+        DESCRIPTOR_CAS_ATTEMPTS,
+        DESCRIPTOR_CAS_FAILURES,
+        HELPED_WRITES,
+        BUCKET_ALLOCATIONS,
+        BUCKET_ALLOCATION_RACES,
+        DESCRIPTOR_ALLOCATIONS,
+        NUM_COUNTERS
+    };
+
+private:
+    static constexpr size_t SHARDS = 64;
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counters_[NUM_COUNTERS] = {};
+        std::atomic<uint64_t> max_retries_{0};
+    };
+
+    Shard shards_[SHARDS];
+
+    static Shard& shard_of(Shard* shards) {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return shards[shard];
+    }
+
+public:
+    void add(Counter counter, uint64_t n = 1) {
+        shard_of(shards_).counters_[counter].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // one finished operation that took retries extra attempts
+    void record_operation(uint64_t retries) {
+        Shard& shard = shard_of(shards_);
+        shard.counters_[OPERATIONS].fetch_add(1, std::memory_order_relaxed);
+        if (retries == 0) return;
+        shard.counters_[RETRIES].fetch_add(retries, std::memory_order_relaxed);
+        uint64_t max = shard.max_retries_.load(std::memory_order_relaxed);
+        while (retries > max && !shard.max_retries_.compare_exchange_weak(max, retries, std::memory_order_relaxed)) {}
+    }
+
+    VectorStats collect() const {
+        uint64_t totals[NUM_COUNTERS] = {};
+        VectorStats stats;
+        for (const Shard& shard : shards_) {
+            for (size_t i = 0; i < NUM_COUNTERS; i++) {
+                totals[i] += shard.counters_[i].load(std::memory_order_relaxed);
+            }
+            stats.max_retries_ = std::max(stats.max_retries_, shard.max_retries_.load(std::memory_order_relaxed));
+        }
+        stats.operations_ = totals[OPERATIONS];
+        stats.retries_ = totals[RETRIES];
+        stats.reads_ = totals[READS];
+        stats.writes_ = totals[WRITES];
+        stats.descriptor_cas_attempts_ = totals[DESCRIPTOR_CAS_ATTEMPTS];
+        stats.descriptor_cas_failures_ = totals[DESCRIPTOR_CAS_FAILURES];
+        stats.helped_writes_ = totals[HELPED_WRITES];
+        stats.bucket_allocations_ = totals[BUCKET_ALLOCATIONS];
+        stats.bucket_allocation_races_ = totals[BUCKET_ALLOCATION_RACES];
+        stats.descriptor_allocations_ = totals[DESCRIPTOR_ALLOCATIONS];
+        return stats;
+    }
+};
+
+// counters only exist in builds with LFV_STATS defined, otherwise every hook is empty
+#ifdef LFV_STATS
+#define LFV_COUNT(counter) stats_.add(StatsCounters::counter)
+#define LFV_RECORD_OPERATION(retries) stats_.record_operation(retries)
+#else
+#define LFV_COUNT(counter) ((void)0)
+#define LFV_RECORD_OPERATION(retries) ((void)(retries))
+#endif
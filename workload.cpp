@@ -0,0 +1,464 @@
+// workload-matrix driver: runs every combination of the given parameters against LockFreeVector
+// and a mutex-guarded std::vector and prints one JSON object or CSV row per combination.
+//
+//   lfv_workload [--impl=lockfree,mutex] [--mix=push:15,pop:5,write:10,read:70 ...]
+//                [--dist=uniform,zipf:0.99,hot:0.9:0.1] [--elem=4,8,16,64]
+//                [--preload=10000] [--threads=1,2,4] [--duration=1] [--format=json|csv] [--out=path]
+//                [--rate=0,100000,1000000] [--arrival=poisson|constant]
+//
+// --mix can be given several times, every other list option is comma separated. hot:P:F sends a
+// fraction P of the keyed operations (read/write) to the newest fraction F of the elements;
+// zipf:S draws ranks with skew S, rank 0 being the oldest element.
+//
+// rate 0 is closed loop, each thread issues its next operation as soon as the previous one returns.
+// any other rate is open loop: operations are scheduled at rate per second over all threads with
+// poisson or constant gaps, and latency is measured from the scheduled start, so time spent queued
+// behind a slow operation counts (coordinated omission), and so do arrivals still waiting when the
+// run stops, with the time waited until then. service_p99 is the closed-loop view of the same run,
+// measured from the actual start
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lock-free-vector.cpp"
+
+namespace {
+
+template <size_t Bytes>
+struct Element {
+    uint64_t words_[Bytes / 8];
+};
+
+template <typename T>
+T make_value(uint64_t v) {
+    if constexpr (std::is_integral_v<T>) {
+        return static_cast<T>(v);
+    } else {
+        T value{};
+        value.words_[0] = v;
+        return value;
+    }
+}
+
+template <typename T>
+class MutexVector {
+    std::vector<T> vec_;
+    std::mutex mutex_;
+
+public:
+    void push_back(const T& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        vec_.push_back(value);
+    }
+
+    T pop_back() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (vec_.empty()) throw std::out_of_range("empty");
+        T value = vec_.back();
+        vec_.pop_back();
+        return value;
+    }
+
+    T read(size_t i) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return vec_[i];
+    }
+
+    void write(size_t i, const T& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        vec_[i] = value;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return vec_.size();
+    }
+};
+
+enum Op { PUSH, POP, WRITE, READ, NUM_OPS };
+const char* const OP_NAMES[NUM_OPS] = {"push", "pop", "write", "read"};
+
+struct Mix {
+    std::string spec_;
+    unsigned percent_[NUM_OPS] = {};
+};
+
+struct Distribution {
+    std::string spec_;
+    enum Kind { UNIFORM, ZIPF, HOT } kind_ = UNIFORM;
+    double skew_ = 0.99;        // zipf
+    double hot_ops_ = 0.9;      // hot: fraction of operations
+    double hot_range_ = 0.1;    // hot: newest fraction of elements
+};
+
+struct Config {
+    std::string impl_;
+    Mix mix_;
+    Distribution dist_;
+    size_t elem_size_;
+    size_t preload_;
+    int threads_;
+    double duration_;
+    double rate_;           // operations per second over all threads, 0 for closed loop
+    bool poisson_;
+};
+
+struct Result {
+    double seconds_ = 0;
+    uint64_t ops_[NUM_OPS] = {};
+    LatencyHistogram latency_;   // from the scheduled start in open loop
+    LatencyHistogram service_;   // from the actual start
+};
+
+// YCSB's zipfian generator (Gray et al., "Quickly generating billion-record synthetic databases")
+class ZipfGenerator {
+    uint64_t n_;
+    double theta_, alpha_, zetan_, eta_;
+
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; i++) sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        return sum;
+    }
+
+public:
+    ZipfGenerator(uint64_t n, double theta)
+        : n_(std::max<uint64_t>(n, 2))
+        , theta_(theta)
+        , alpha_(1.0 / (1.0 - theta))
+        , zetan_(zeta(n_, theta)) {
+        eta_ = (1 - std::pow(2.0 / static_cast<double>(n_), 1 - theta_)) / (1 - zeta(2, theta_) / zetan_);
+    }
+
+    template <typename Gen>
+    uint64_t operator()(Gen& gen) const {
+        double u = std::uniform_real_distribution<double>(0, 1)(gen);
+        double uz = u * zetan_;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta_)) return 1;
+        return static_cast<uint64_t>(static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1, alpha_));
+    }
+};
+
+template <typename Vec, typename T>
+void run_config(const Config& config, Result& result) {
+    Vec vec;
+    for (size_t i = 0; i < config.preload_; ++i) vec.push_back(make_value<T>(i));
+
+    // zeta is O(n), computed once and shared by every thread
+    std::unique_ptr<ZipfGenerator> zipf;
+    if (config.dist_.kind_ == Distribution::ZIPF) {
+        zipf = std::make_unique<ZipfGenerator>(std::max<size_t>(config.preload_, 1), config.dist_.skew_);
+    }
+
+    std::atomic<bool> start{false}, stop{false};
+    std::vector<Result> per_thread(config.threads_);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < config.threads_; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 gen(t + 1);
+            std::uniform_int_distribution<unsigned> op_dist(0, 99);
+            std::uniform_real_distribution<double> unit(0, 1);
+            Result& local = per_thread[t];
+
+            auto pick_index = [&](size_t size) -> size_t {
+                switch (config.dist_.kind_) {
+                    case Distribution::ZIPF:
+                        return (*zipf)(gen) % size;
+                    case Distribution::HOT:
+                        if (unit(gen) < config.dist_.hot_ops_) {
+                            size_t hot = std::max<size_t>(1, static_cast<size_t>(size * config.dist_.hot_range_));
+                            return size - 1 - static_cast<size_t>(unit(gen) * hot) % hot;
+                        }
+                        [[fallthrough]];
+                    default:
+                        return static_cast<size_t>(unit(gen) * size) % size;
+                }
+            };
+
+            // open loop schedule in CycleClock ticks, each thread runs its share of the rate
+            double ns_per_tick = CycleClock::ns_per_tick();
+            double gap_ticks = config.rate_ > 0 ? 1e9 * config.threads_ / config.rate_ / ns_per_tick : 0;
+            std::exponential_distribution<double> arrival(1.0);
+            auto next_gap = [&]() {
+                return static_cast<uint64_t>(config.poisson_ ? gap_ticks * arrival(gen) : gap_ticks);
+            };
+
+            while (!start.load(std::memory_order_acquire)) {}
+            uint64_t scheduled = CycleClock::now() + next_gap();
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (gap_ticks > 0) {
+                    // sleep while far from the next start, spin for the last stretch
+                    for (uint64_t now = CycleClock::now(); now < scheduled; now = CycleClock::now()) {
+                        if (stop.load(std::memory_order_relaxed)) break;
+                        double remaining_ns = static_cast<double>(scheduled - now) * ns_per_tick;
+                        if (remaining_ns > 100000) {
+                            std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<int64_t>(remaining_ns) - 50000));
+                        }
+                    }
+                    if (stop.load(std::memory_order_relaxed)) break;
+                }
+
+                unsigned roll = op_dist(gen);
+                Op op = READ;
+                for (unsigned o = 0, acc = 0; o < NUM_OPS; ++o) {
+                    acc += config.mix_.percent_[o];
+                    if (roll < acc) {
+                        op = static_cast<Op>(o);
+                        break;
+                    }
+                }
+
+                uint64_t begin = CycleClock::now();
+                switch (op) {
+                    case PUSH:
+                        vec.push_back(make_value<T>(roll));
+                        break;
+                    case POP:
+                        try {
+                            vec.pop_back();
+                        } catch (const std::out_of_range&) {}
+                        break;
+                    case WRITE:
+                    case READ: {
+                        size_t size = vec.size();
+                        if (size == 0) break;
+                        size_t index = pick_index(size);
+                        if (op == WRITE) {
+                            vec.write(index, make_value<T>(roll));
+                        } else {
+                            T value = vec.read(index);
+                            asm volatile("" : : "r"(&value) : "memory");
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                }
+                uint64_t end = CycleClock::now();
+                local.service_.record(static_cast<uint64_t>(static_cast<double>(end - begin) * ns_per_tick));
+                if (gap_ticks > 0) {
+                    local.latency_.record(static_cast<uint64_t>(static_cast<double>(end - scheduled) * ns_per_tick));
+                    scheduled += next_gap();
+                } else {
+                    local.latency_.record(static_cast<uint64_t>(static_cast<double>(end - begin) * ns_per_tick));
+                }
+                local.ops_[op]++;
+            }
+
+            // arrivals already due when the run stopped were never issued, they still count with the
+            // time waited so far, or a run that fell behind would drop exactly its slowest samples
+            if (gap_ticks > 0) {
+                for (uint64_t now = CycleClock::now(); scheduled <= now; scheduled += std::max<uint64_t>(next_gap(), 1)) {
+                    local.latency_.record(static_cast<uint64_t>(static_cast<double>(now - scheduled) * ns_per_tick));
+                }
+            }
+        });
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.duration_));
+    stop.store(true);
+    // taken before the join, recording the overdue arrivals of an overloaded run takes a while
+    result.seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    for (auto& thread : threads) thread.join();
+
+    for (const Result& local : per_thread) {
+        for (int o = 0; o < NUM_OPS; ++o) result.ops_[o] += local.ops_[o];
+        result.latency_.merge(local.latency_);
+        result.service_.merge(local.service_);
+    }
+}
+
+template <typename T>
+void run_impl(const Config& config, Result& result) {
+    if (config.impl_ == "mutex") {
+        run_config<MutexVector<T>, T>(config, result);
+    } else {
+        run_config<LockFreeVector<T>, T>(config, result);
+    }
+}
+
+void run(const Config& config, Result& result) {
+    switch (config.elem_size_) {
+        case 4: run_impl<int32_t>(config, result); break;
+        case 8: run_impl<int64_t>(config, result); break;
+        case 16: run_impl<Element<16>>(config, result); break;
+        case 32: run_impl<Element<32>>(config, result); break;
+        case 64: run_impl<Element<64>>(config, result); break;
+        default: throw std::invalid_argument("element size must be 4, 8, 16, 32 or 64");
+    }
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream stream(s);
+    std::string part;
+    while (std::getline(stream, part, sep)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+Mix parse_mix(const std::string& spec) {
+    Mix mix;
+    mix.spec_ = spec;
+    unsigned total = 0;
+    for (const std::string& entry : split(spec, ',')) {
+        auto fields = split(entry, ':');
+        if (fields.size() != 2) throw std::invalid_argument("bad mix entry: " + entry);
+        auto name = std::find(std::begin(OP_NAMES), std::end(OP_NAMES), fields[0]);
+        if (name == std::end(OP_NAMES)) throw std::invalid_argument("unknown operation: " + fields[0]);
+        unsigned percent = static_cast<unsigned>(std::stoul(fields[1]));
+        mix.percent_[name - std::begin(OP_NAMES)] = percent;
+        total += percent;
+    }
+    if (total != 100) throw std::invalid_argument("mix must add up to 100: " + spec);
+    return mix;
+}
+
+Distribution parse_distribution(const std::string& spec) {
+    Distribution dist;
+    dist.spec_ = spec;
+    auto fields = split(spec, ':');
+    if (fields.empty()) throw std::invalid_argument("empty distribution");
+    if (fields[0] == "uniform") {
+        dist.kind_ = Distribution::UNIFORM;
+    } else if (fields[0] == "zipf") {
+        dist.kind_ = Distribution::ZIPF;
+        if (fields.size() > 1) dist.skew_ = std::stod(fields[1]);
+    } else if (fields[0] == "hot") {
+        dist.kind_ = Distribution::HOT;
+        if (fields.size() > 1) dist.hot_ops_ = std::stod(fields[1]);
+        if (fields.size() > 2) dist.hot_range_ = std::stod(fields[2]);
+    } else {
+        throw std::invalid_argument("unknown distribution: " + spec);
+    }
+    return dist;
+}
+
+template <typename T, typename Parse>
+std::vector<T> parse_list(const std::string& s, Parse parse) {
+    std::vector<T> values;
+    for (const std::string& part : split(s, ',')) values.push_back(parse(part));
+    return values;
+}
+
+const double PERCENTILES[] = {50, 90, 99, 99.9, 99.99};
+const char* const PERCENTILE_NAMES[] = {"p50", "p90", "p99", "p99_9", "p99_99"};
+
+void write_csv_header(std::ostream& out) {
+    out << "impl,mix,dist,elem_size,preload,threads,rate,arrival,seconds,ops_per_sec";
+    for (const char* op : OP_NAMES) out << "," << op << "_ops";
+    for (const char* p : PERCENTILE_NAMES) out << "," << p << "_ns";
+    out << ",max_ns,service_p99_ns\n";
+}
+
+void write_csv(std::ostream& out, const Config& config, const Result& result) {
+    uint64_t total = 0;
+    for (uint64_t n : result.ops_) total += n;
+    out << config.impl_ << ",\"" << config.mix_.spec_ << "\"," << config.dist_.spec_ << "," << config.elem_size_
+        << "," << config.preload_ << "," << config.threads_ << "," << config.rate_ << ","
+        << (config.poisson_ ? "poisson" : "constant") << "," << result.seconds_ << ","
+        << static_cast<double>(total) / result.seconds_;
+    for (uint64_t n : result.ops_) out << "," << n;
+    for (double p : PERCENTILES) out << "," << result.latency_.percentile(p);
+    out << "," << result.latency_.max() << "," << result.service_.percentile(99) << "\n";
+}
+
+void write_json(std::ostream& out, const Config& config, const Result& result, bool first) {
+    uint64_t total = 0;
+    for (uint64_t n : result.ops_) total += n;
+    out << (first ? "  " : ",\n  ") << "{\"impl\": \"" << config.impl_ << "\", \"mix\": \"" << config.mix_.spec_
+        << "\", \"dist\": \"" << config.dist_.spec_ << "\", \"elem_size\": " << config.elem_size_
+        << ", \"preload\": " << config.preload_ << ", \"threads\": " << config.threads_
+        << ", \"rate\": " << config.rate_ << ", \"arrival\": \"" << (config.poisson_ ? "poisson" : "constant") << "\""
+        << ", \"seconds\": " << result.seconds_ << ", \"ops_per_sec\": " << static_cast<double>(total) / result.seconds_
+        << ", \"ops\": {";
+    for (int o = 0; o < NUM_OPS; ++o) out << (o ? ", " : "") << "\"" << OP_NAMES[o] << "\": " << result.ops_[o];
+    out << "}, \"latency_ns\": {";
+    for (size_t i = 0; i < std::size(PERCENTILES); ++i) {
+        out << (i ? ", " : "") << "\"" << PERCENTILE_NAMES[i] << "\": " << result.latency_.percentile(PERCENTILES[i]);
+    }
+    out << ", \"max\": " << result.latency_.max() << ", \"service_p99\": " << result.service_.percentile(99) << "}}";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> impls = {"lockfree", "mutex"};
+    std::vector<Mix> mixes;
+    std::vector<Distribution> dists = {parse_distribution("uniform")};
+    std::vector<size_t> elem_sizes = {4};
+    std::vector<size_t> preloads = {10000};
+    std::vector<int> thread_counts = {1, 2, 4};
+    std::vector<double> rates = {0};
+    double duration = 1.0;
+    bool poisson = true;
+    std::string format = "json", out_path;
+
+    auto to_size = [](const std::string& s) { return static_cast<size_t>(std::stoull(s)); };
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            std::string key = arg.substr(0, eq), value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+            if (key == "--impl") impls = split(value, ',');
+            else if (key == "--mix") mixes.push_back(parse_mix(value));
+            else if (key == "--dist") dists = parse_list<Distribution>(value, parse_distribution);
+            else if (key == "--elem") elem_sizes = parse_list<size_t>(value, to_size);
+            else if (key == "--preload") preloads = parse_list<size_t>(value, to_size);
+            else if (key == "--threads") thread_counts = parse_list<int>(value, [](const std::string& s) { return std::stoi(s); });
+            else if (key == "--duration") duration = std::stod(value);
+            else if (key == "--rate") rates = parse_list<double>(value, [](const std::string& s) { return std::stod(s); });
+            else if (key == "--arrival") {
+                if (value != "poisson" && value != "constant") throw std::invalid_argument("arrival must be poisson or constant");
+                poisson = value == "poisson";
+            }
+            else if (key == "--format") format = value;
+            else if (key == "--out") out_path = value;
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        // the mix run_mixed_ops_benchmark in main.cpp uses
+        if (mixes.empty()) mixes.push_back(parse_mix("push:15,pop:5,write:10,read:70"));
+        if (format != "json" && format != "csv") throw std::invalid_argument("format must be json or csv");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+
+    std::ofstream file;
+    if (!out_path.empty()) file.open(out_path);
+    std::ostream& out = out_path.empty() ? std::cout : file;
+
+    bool first = true;
+    if (format == "csv") write_csv_header(out);
+    else out << "[\n";
+    for (const std::string& impl : impls)
+        for (const Mix& mix : mixes)
+            for (const Distribution& dist : dists)
+                for (size_t elem_size : elem_sizes)
+                    for (size_t preload : preloads)
+                        for (int threads : thread_counts)
+                            for (double rate : rates) {
+                                Config config{impl, mix, dist, elem_size, preload, threads, duration, rate, poisson};
+                                Result result;
+                                run(config, result);
+                                if (format == "csv") write_csv(out, config, result);
+                                else write_json(out, config, result, first);
+                                out.flush();
+                                first = false;
+                            }
+    if (format == "json") out << "\n]\n";
+    return 0;
+}